@@ -0,0 +1,77 @@
+/*********************************************************************
+ * Integer exponential backoff with jitter
+ *
+ * After a coordinator reboot every device loses its parent at the same
+ * moment; a deterministic schedule makes them all retry in lockstep and
+ * collide on beacons. Jitter is drawn from a xorshift generator seeded
+ * from the IEEE address (plus the radio RNG), so each device gets its own
+ * sequence and a whole site recovers spread out instead of in bursts.
+ *********************************************************************/
+
+#include "backoff.h"
+#include "OSAL.h"
+#include "ZDApp.h"
+
+static uint16 backoff_lfsr = 0;
+
+void backoff_Seed(void) {
+    uint8 *ieee = NLME_GetExtAddr();
+    uint16 seed = osal_rand();
+    if (ieee != NULL) {
+        for (uint8 i = 0; i < Z_EXTADDR_LEN; i++) {
+            seed = (seed << 3) ^ (seed >> 13) ^ ieee[i];
+        }
+    }
+    backoff_lfsr = seed ? seed : 0xACE1; // xorshift must not start at 0
+}
+
+uint16 backoff_Rand(void) {
+    if (backoff_lfsr == 0) {
+        backoff_Seed();
+    }
+    // xorshift16 (7, 9, 8)
+    backoff_lfsr ^= backoff_lfsr << 7;
+    backoff_lfsr ^= backoff_lfsr >> 9;
+    backoff_lfsr ^= backoff_lfsr << 8;
+    return backoff_lfsr;
+}
+
+// Uniform-ish value in [lo, hi]
+static uint32 backoff_Between(uint32 lo, uint32 hi) {
+    if (hi <= lo) {
+        return lo;
+    }
+    uint32 r = ((uint32)backoff_Rand() << 16) | backoff_Rand();
+    return lo + r % (hi - lo + 1);
+}
+
+static uint32 backoff_Grow(uint32 value, uint32 cap) {
+    if (value >= cap / BACKOFF_FACTOR_NUM) {
+        return cap; // would overflow or exceed cap anyway
+    }
+    return MIN(cap, value * BACKOFF_FACTOR_NUM / BACKOFF_FACTOR_DEN);
+}
+
+uint32 backoff_Next(uint8 mode, uint32 base, uint32 prev, uint8 attempt, uint32 cap) {
+    uint32 ceiling;
+
+    switch (mode) {
+    case BACKOFF_JITTER_FULL:
+        ceiling = base;
+        while (attempt-- && ceiling < cap) {
+            ceiling = backoff_Grow(ceiling, cap);
+        }
+        return backoff_Between(base, ceiling);
+
+    case BACKOFF_JITTER_DECORRELATED:
+        ceiling = (prev >= cap / 3) ? cap : MIN(cap, prev * 3);
+        return backoff_Between(base, MAX(ceiling, base));
+
+    default:
+        return backoff_Grow(MAX(prev, base), cap);
+    }
+}
+
+uint32 backoff_Spread(uint32 interval, uint8 spreadShift) {
+    return backoff_Between(interval - (interval >> spreadShift), interval);
+}
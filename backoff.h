@@ -0,0 +1,28 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include "hal_types.h"
+
+// Jitter modes
+#define BACKOFF_JITTER_NONE         0 // deterministic: prev * NUM / DEN
+#define BACKOFF_JITTER_FULL         1 // uniform in [base, base * (NUM/DEN)^attempt]
+#define BACKOFF_JITTER_DECORRELATED 2 // uniform in [base, prev * 3]
+
+// Integer growth factor (1.5 without floating point)
+#ifndef BACKOFF_FACTOR_NUM
+    #define BACKOFF_FACTOR_NUM 3
+#endif
+
+#ifndef BACKOFF_FACTOR_DEN
+    #define BACKOFF_FACTOR_DEN 2
+#endif
+
+// Seed the jitter generator from the IEEE address so co-located devices diverge
+extern void backoff_Seed(void);
+extern uint16 backoff_Rand(void);
+// Next retry delay. prev = last delay (decorrelated), attempt = 0-based retry count (full), cap = upper bound
+extern uint32 backoff_Next(uint8 mode, uint32 base, uint32 prev, uint8 attempt, uint32 cap);
+// Spread a fixed interval uniformly over [interval - interval/2^spreadShift, interval]
+extern uint32 backoff_Spread(uint32 interval, uint8 spreadShift);
+
+#endif
@@ -1,5 +1,11 @@
 #include "Debug.h"
 #include "battery.h"
+#include "battery_forecast.h"
+#include "power_profile.h"
+#include "report_frame.h"
+#include "report_phase.h"
+#include "report_queue.h"
+#include "wake_scheduler.h"
 #include "hal_adc.h"
 #include "utils.h"
 #include "OSAL.h"
@@ -23,30 +29,93 @@
     #define ZCL_BATTERY_REPORT_DELAY 5 * 1000
 #endif
 
+// How much later than the delay the key-triggered report may go out to share a wakeup
+#ifndef ZCL_BATTERY_REPORT_TOLERANCE
+    #define ZCL_BATTERY_REPORT_TOLERANCE 2000
+#endif
+
+// Library-driven periodic report every ZCL_BATTERY_REPORT_INTERVAL, in this device's report slot.
+// Off by default: most apps sample the battery in their own sensor cycle.
+#ifndef ZCL_BATTERY_PERIODIC_REPORT
+    #define ZCL_BATTERY_PERIODIC_REPORT FALSE
+#endif
+
+// Lateness allowed for the periodic report - well inside one report slot so the phase holds
+#ifndef ZCL_BATTERY_PERIODIC_TOLERANCE
+    #define ZCL_BATTERY_PERIODIC_TOLERANCE (ZCL_BATTERY_REPORT_INTERVAL / (REPORT_PHASE_SLOTS * 4))
+#endif
+
 #ifndef ZCL_BATTERY_REPORT_REPORT_CONVERTER
 #define ZCL_BATTERY_REPORT_REPORT_CONVERTER(millivolts) getBatteryRemainingPercentageZCLCR2032(millivolts)
 #endif
 
 #define POWER_CFG ZCL_CLUSTER_ID_GEN_POWER_CFG
 
+// Battery reports are periodic and superseded by the next one - no APS ACK by default
+#ifndef ZCL_BATTERY_REPORT_CLASS
+    #define ZCL_BATTERY_REPORT_CLASS ZCL_REPORT_CLASS_FIRE_AND_FORGET
+#endif
+
+// Sample VDD right after TX/poll (cell under load) and derive percentage from it
+#ifndef ZCL_BATTERY_LOADED_SAMPLING
+    #define ZCL_BATTERY_LOADED_SAMPLING TRUE
+#endif
+
+// Minimum spacing between loaded samples - confirms can arrive in bursts
+#ifndef ZCL_BATTERY_LOADED_SAMPLE_INTERVAL
+    #define ZCL_BATTERY_LOADED_SAMPLE_INTERVAL ((uint32)60000) // 1 minute
+#endif
+
 #define ZCL_BATTERY_REPORT_EVT 0x0001
 
 
 uint8 zclBattery_Voltage = 0xff;
 uint8 zclBattery_PercentageRemainig = 0xff;
 uint16 zclBattery_RawAdc = 0xff;
+uint16 zclBattery_IdleMillivolts = 0;
+uint16 zclBattery_LoadedMillivolts = 0;
+uint16 zclBattery_VoltageSag = 0;
+
+#if ZCL_BATTERY_LOADED_SAMPLING
+static uint32 zclBattery_LastLoadedSample = 0;
+static bool zclBattery_LoadedSampled = false;
+#endif
 
 uint8 getBatteryVoltageZCL(uint16 millivolts) {
     // Proper rounding: add 50 before dividing by 100
     // This ensures values like 295 round to 3, not truncate to 2
     return (uint8)((millivolts + 50) / 100);
 }
+
+static uint16 zclBattery_SampleMillivolts(uint16 *rawAdc) {
+    // 4 samples averaged by shift. The first conversion is always discarded: the ADC was asleep, and
+    // app or HAL reads may have switched the reference behind utils.c's back.
+    uint16 raw = adcReadOversampled(HAL_ADC_CHANNEL_VDD, HAL_ADC_RESOLUTION_14, HAL_ADC_REF_125V, 2, 0,
+                                    ADC_FLAG_DISCARD_FIRST | ADC_FLAG_ALWAYS_DISCARD);
+    if (rawAdc != NULL) {
+        *rawAdc = raw;
+    }
+    return (uint16)(raw * MULTI);
+}
+
 // return millivolts
-uint16 getBatteryVoltage(void) {
-    HalAdcSetReference(HAL_ADC_REF_125V);
-    // Reduced from 10 to 5 samples - still accurate for battery voltage
-    zclBattery_RawAdc = adcReadSampled(HAL_ADC_CHANNEL_VDD, HAL_ADC_RESOLUTION_14, HAL_ADC_REF_125V, 5);
-    return (uint16)(zclBattery_RawAdc * MULTI);
+uint16 getBatteryVoltage(void) { return zclBattery_SampleMillivolts(&zclBattery_RawAdc); }
+
+void zclBattery_SampleLoaded(void) {
+#if ZCL_BATTERY_LOADED_SAMPLING
+    uint32 now = osal_GetSystemClock();
+    if (zclBattery_LoadedSampled && (now - zclBattery_LastLoadedSample) < ZCL_BATTERY_LOADED_SAMPLE_INTERVAL) {
+        return;
+    }
+    zclBattery_LastLoadedSample = now;
+    zclBattery_LoadedSampled = true;
+
+    uint16 millivolts = zclBattery_SampleMillivolts(NULL);
+    // Keep the deepest sag seen since the last report - that's the one that browns out
+    if (zclBattery_LoadedMillivolts == 0 || millivolts < zclBattery_LoadedMillivolts) {
+        zclBattery_LoadedMillivolts = millivolts;
+    }
+#endif
 }
 
 uint8 getBatteryRemainingPercentageZCL(uint16 millivolts) { return (uint8)mapRange(VOLTAGE_MIN, VOLTAGE_MAX, 0.0, 200.0, millivolts); }
@@ -105,39 +174,57 @@ uint8 getBatteryRemainingPercentageZCLAlkaline2S(uint16 mv) {
     return (uint8)(p * 2);
 }
 
-static void zclBattery_SendReportDirect(void) {
-    const uint8 NUM_ATTRIBUTES = 3;
-    zclReportCmd_t *pReportCmd;
-    pReportCmd = osal_mem_alloc(sizeof(zclReportCmd_t) + (NUM_ATTRIBUTES * sizeof(zclReport_t)));
-    if (pReportCmd != NULL) {
-        pReportCmd->numAttr = NUM_ATTRIBUTES;
-
-        pReportCmd->attrList[0].attrID = ATTRID_POWER_CFG_BATTERY_VOLTAGE;
-        pReportCmd->attrList[0].dataType = ZCL_DATATYPE_UINT8;
-        pReportCmd->attrList[0].attrData = (void *)(&zclBattery_Voltage);
+// Attribute bindings for the direct report - pointers stay valid, values are read at send time
+static const zclReport_t zclBattery_ReportBindings[] = {
+    {ATTRID_POWER_CFG_BATTERY_VOLTAGE, ZCL_DATATYPE_UINT8, (void *)(&zclBattery_Voltage)},
+    {ATTRID_POWER_CFG_BATTERY_PERCENTAGE_REMAINING, ZCL_DATATYPE_UINT8, (void *)(&zclBattery_PercentageRemainig)},
+    {ATTRID_POWER_CFG_BATTERY_VOLTAGE_RAW_ADC, ZCL_DATATYPE_UINT16, (void *)(&zclBattery_RawAdc)},
+    {ATTRID_POWER_CFG_BATTERY_VOLTAGE_SAG, ZCL_DATATYPE_UINT16, (void *)(&zclBattery_VoltageSag)},
+    {ATTRID_POWER_CFG_BATTERY_DAYS_REMAINING, ZCL_DATATYPE_UINT16, (void *)(&zclBattery_DaysRemaining)},
+    {ATTRID_POWER_CFG_POWER_PROFILE, ZCL_DATATYPE_ENUM8, (void *)(&zclPowerProfile_Current)},
+};
+#define ZCL_BATTERY_REPORT_NUM_ATTRS (sizeof(zclBattery_ReportBindings) / sizeof(zclBattery_ReportBindings[0]))
 
-        pReportCmd->attrList[1].attrID = ATTRID_POWER_CFG_BATTERY_PERCENTAGE_REMAINING;
-        pReportCmd->attrList[1].dataType = ZCL_DATATYPE_UINT8;
-        pReportCmd->attrList[1].attrData = (void *)(&zclBattery_PercentageRemainig);
+ZCL_REPORT_FRAME_DECLARE(zclBattery_ReportStorage, ZCL_BATTERY_REPORT_NUM_ATTRS);
+static zclReportCmd_t *zclBattery_ReportFrame = NULL;
 
-        pReportCmd->attrList[2].attrID = ATTRID_POWER_CFG_BATTERY_VOLTAGE_RAW_ADC;
-        pReportCmd->attrList[2].dataType = ZCL_DATATYPE_UINT16;
-        pReportCmd->attrList[2].attrData = (void *)(&zclBattery_RawAdc);
+static void zclBattery_SendReportDirect(void) {
+    if (zclBattery_ReportFrame == NULL) {
+        zclBattery_ReportFrame = zclReportFrame_Build(zclBattery_ReportStorage, zclBattery_ReportBindings, ZCL_BATTERY_REPORT_NUM_ATTRS);
+    }
+    zclReportFrame_SendClass(1, POWER_CFG, zclBattery_ReportFrame, ZCL_BATTERY_REPORT_CLASS);
+}
 
-        afAddrType_t inderect_DstAddr = {.addrMode = (afAddrMode_t)AddrNotPresent, .endPoint = 0, .addr.shortAddr = 0};
-        zcl_SendReportCmd(1, &inderect_DstAddr, POWER_CFG, pReportCmd, ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, bdb_getZCLFrameCounter());
+void zclBattery_Sample(void) {
+    uint16 millivolts = getBatteryVoltage();
+    zclBattery_IdleMillivolts = millivolts;
+    zclBattery_VoltageSag = 0;
 
-        // Free memory only if allocation succeeded
-        osal_mem_free(pReportCmd);
+    // Percentage follows the loaded voltage so replacement alerts fire before TX brown-outs
+    if (zclBattery_LoadedMillivolts != 0 && zclBattery_LoadedMillivolts < millivolts) {
+        zclBattery_VoltageSag = millivolts - zclBattery_LoadedMillivolts;
+        millivolts = zclBattery_LoadedMillivolts;
     }
+    // Start a fresh loaded window for the next report
+    zclBattery_LoadedMillivolts = 0;
+
+    zclBattery_Voltage = getBatteryVoltageZCL(zclBattery_IdleMillivolts);
+    zclBattery_PercentageRemainig = ZCL_BATTERY_REPORT_REPORT_CONVERTER(millivolts);
+    zclBatteryForecast_Update(millivolts, zclBattery_PercentageRemainig);
+    zclPowerProfile_Update(zclBattery_PercentageRemainig);
 }
 
 void zclBattery_Report(void) {
-    uint16 millivolts = getBatteryVoltage();
-    zclBattery_Voltage = getBatteryVoltageZCL(millivolts);
-    zclBattery_PercentageRemainig = ZCL_BATTERY_REPORT_REPORT_CONVERTER(millivolts);
+    zclBattery_Sample();
 
-    LREP("Battery voltageZCL=%d prc=%d voltage=%d\r\n", zclBattery_Voltage, zclBattery_PercentageRemainig, millivolts);
+    LREP("Battery voltageZCL=%d prc=%d idle=%d sag=%d\r\n", zclBattery_Voltage, zclBattery_PercentageRemainig,
+         zclBattery_IdleMillivolts, zclBattery_VoltageSag);
+
+    // Offline: keep the reading for the history frames after the rejoin instead of reporting into the void
+    if (reportQueue_Push(REPORT_QUEUE_SLOT_BATTERY_MV, (int16)(zclBattery_IdleMillivolts - zclBattery_VoltageSag))) {
+        reportQueue_Push(REPORT_QUEUE_SLOT_BATTERY_PERCENT, zclBattery_PercentageRemainig);
+        return;
+    }
 
 #if BDB_REPORTING
     bdb_RepChangedAttrValue(1, POWER_CFG, ATTRID_POWER_CFG_BATTERY_PERCENTAGE_REMAINING);
@@ -149,18 +236,29 @@ void zclBattery_Report(void) {
 void zclBattery_ReportNow(void) {
     // Use the latest sampled values if available; otherwise sample now
     if (zclBattery_RawAdc == 0xff) {
-        uint16 millivolts = getBatteryVoltage();
-        zclBattery_Voltage = getBatteryVoltageZCL(millivolts);
-        zclBattery_PercentageRemainig = ZCL_BATTERY_REPORT_REPORT_CONVERTER(millivolts);
+        zclBattery_Sample();
     }
     zclBattery_SendReportDirect();
 }
 
 uint8 zclBattery_TaskId = 0;
 
+static void zclBattery_SchedulePeriodic(void) {
+#if ZCL_BATTERY_PERIODIC_REPORT
+    // Low battery tiers stretch the cadence (and the slack to share a wakeup with it)
+    wakeScheduler_Start(zclBattery_TaskId, ZCL_BATTERY_REPORT_EVT,
+                        reportPhase_NextDelay(zclPowerProfile_ScaleInterval(ZCL_BATTERY_REPORT_INTERVAL)),
+                        zclPowerProfile_ScaleInterval(ZCL_BATTERY_PERIODIC_TOLERANCE));
+#endif
+}
+
 void zclBattery_Init(uint8 task_id) {
     zclBattery_TaskId = task_id;
-    // Battery reporting is handled by the main sensor cycle to avoid duplicate sampling.
+    zclBatteryForecast_Init();
+    zclBattery_ReportFrame = zclReportFrame_Build(zclBattery_ReportStorage, zclBattery_ReportBindings, ZCL_BATTERY_REPORT_NUM_ATTRS);
+    // Battery reporting is handled by the main sensor cycle to avoid duplicate sampling,
+    // unless ZCL_BATTERY_PERIODIC_REPORT hands the cadence to the wake scheduler.
+    zclBattery_SchedulePeriodic();
 }
 
 uint16 zclBattery_event_loop(uint8 task_id, uint16 events) {
@@ -168,11 +266,12 @@ uint16 zclBattery_event_loop(uint8 task_id, uint16 events) {
     if (events & ZCL_BATTERY_REPORT_EVT) {
         LREPMaster("ZCL_BATTERY_REPORT_EVT\r\n");
         zclBattery_Report();
+        zclBattery_SchedulePeriodic();
         return (events ^ ZCL_BATTERY_REPORT_EVT);
     }
     return 0;
 }
 
 void zclBattery_HandleKeys(uint8 portAndAction, uint8 keyCode) {
-    osal_start_timerEx(zclBattery_TaskId, ZCL_BATTERY_REPORT_EVT, ZCL_BATTERY_REPORT_DELAY);
+    wakeScheduler_Start(zclBattery_TaskId, ZCL_BATTERY_REPORT_EVT, ZCL_BATTERY_REPORT_DELAY, ZCL_BATTERY_REPORT_TOLERANCE);
 }
@@ -2,11 +2,16 @@
 #define _BATTERY_H
 //This is custom attribute
 #define ATTRID_POWER_CFG_BATTERY_VOLTAGE_RAW_ADC                0x0200
+// Custom attribute: idle minus loaded (post-TX/poll) voltage, mV
+#define ATTRID_POWER_CFG_BATTERY_VOLTAGE_SAG                    0x0201
 
 
 extern uint8 zclBattery_Voltage;
 extern uint8 zclBattery_PercentageRemainig;
 extern uint16 zclBattery_RawAdc;
+extern uint16 zclBattery_IdleMillivolts;
+extern uint16 zclBattery_LoadedMillivolts;
+extern uint16 zclBattery_VoltageSag;
 
 
 extern uint16 getBatteryVoltage(void);
@@ -20,6 +25,13 @@ extern void zclBattery_Init(uint8 task_id);
 extern uint16 zclBattery_event_loop(uint8 task_id, uint16 events);
 extern void zclBattery_HandleKeys(uint8 portAndAction, uint8 keyCode);
 extern void zclBattery_Report(void);
+// Refresh battery attributes without sending (e.g. before zclTelemetry_Send)
+extern void zclBattery_Sample(void);
 // Send immediate report (bypasses BDB reporting throttling)
 extern void zclBattery_ReportNow(void);
+// Sample VDD while the cell is still loaded (ZCL_BATTERY_LOADED_SAMPLING). Called from
+// zclCommissioning_OnTxConfirm and zclCommissioning_OnPollConfirm, i.e. right after each
+// AF_DATA_CONFIRM_CMD and data poll once those hooks are wired (README, Integration).
+// Deepest reading since the last report drives the percentage.
+extern void zclBattery_SampleLoaded(void);
 #endif
@@ -0,0 +1,180 @@
+/*********************************************************************
+ * Battery time-to-empty forecaster
+ *
+ * Lithium cells sit on a flat plateau until they collapse, so the
+ * instantaneous percentage says little about when a device will die.
+ * Two estimates are combined and the more pessimistic one wins:
+ *   1. Voltage trend - smoothed mV drop per day, tracked over whole days
+ *      and stored in NV (one small write per day).
+ *   2. Charge budget - remaining capacity divided by the daily charge
+ *      derived from activity counters (TX, polls, awake time, sensor
+ *      conversions) plus sleep current.
+ * The trend is also scaled up when current activity exceeds the activity
+ * it was learned under (e.g. after a reporting interval was shortened).
+ * TX frames are counted from the commissioning TX confirms, polls from
+ * the poll arbiter's applied rates, conversions and awake time by the
+ * DS18B20 driver; other blocking drivers can add theirs.
+ *********************************************************************/
+
+#include "battery_forecast.h"
+#include "poll_arbiter.h"
+#include "Debug.h"
+#include "OSAL.h"
+#include "OSAL_Nv.h"
+
+#ifndef BATTERY_FORECAST_CAPACITY_MAH
+    #define BATTERY_FORECAST_CAPACITY_MAH 220 // CR2032
+#endif
+
+#ifndef BATTERY_FORECAST_CUTOFF_MV
+    #define BATTERY_FORECAST_CUTOFF_MV 2100
+#endif
+
+// Charge cost per activity, uA*s
+#ifndef BATTERY_FORECAST_COST_TX_FRAME
+    #define BATTERY_FORECAST_COST_TX_FRAME 120 // ~30mA for ~4ms incl. ACK wait
+#endif
+#ifndef BATTERY_FORECAST_COST_POLL
+    #define BATTERY_FORECAST_COST_POLL 60
+#endif
+#ifndef BATTERY_FORECAST_COST_SENSOR_CONVERSION
+    #define BATTERY_FORECAST_COST_SENSOR_CONVERSION 750 // DS18B20: ~1mA for 750ms
+#endif
+#ifndef BATTERY_FORECAST_COST_AWAKE_MS
+    #define BATTERY_FORECAST_COST_AWAKE_MS 7 // ~7mA MCU active
+#endif
+#ifndef BATTERY_FORECAST_SLEEP_UA
+    #define BATTERY_FORECAST_SLEEP_UA 1 // PM2 sleep current
+#endif
+
+#define BATTERY_FORECAST_PERIOD_SEC ((uint32)86400) // trend resolution: 1 day
+#define BATTERY_FORECAST_MIN_PERIODS 2              // trend is noise before this
+#define BATTERY_FORECAST_Q 256                      // trend rate fixed point (mV/day * 256)
+
+// uA*s of remaining charge per ZCL percentage unit (0.5%)
+#define BATTERY_FORECAST_UAS_PER_ZCL_PERCENT ((uint32)BATTERY_FORECAST_CAPACITY_MAH * 18000)
+
+typedef struct {
+    uint16 anchorMv;    // smoothed voltage at the start of the current period
+    uint16 trendRate;   // smoothed drop, mV/day * BATTERY_FORECAST_Q
+    uint32 dailyCharge; // smoothed charge per day, uA*s
+    uint8 periods;      // completed periods (saturating)
+} BatteryForecastState_t;
+
+uint16 zclBattery_DaysRemaining = BATTERY_FORECAST_DAYS_UNKNOWN;
+
+static BatteryForecastState_t forecast = {0};
+static uint16 forecast_smoothedMv = 0;
+static uint32 forecast_periodSeconds = 0;
+static uint32 forecast_periodCharge = 0;
+static uint32 forecast_lastTick = 0; // osal_GetSystemClock() up to which time is accounted
+
+static void zclBatteryForecast_Save(void) {
+    osal_nv_item_init(ZCD_NV_BATTERY_FORECAST, sizeof(BatteryForecastState_t), &forecast);
+    osal_nv_write(ZCD_NV_BATTERY_FORECAST, 0, sizeof(BatteryForecastState_t), &forecast);
+}
+
+void zclBatteryForecast_Init(void) {
+    if (osal_nv_read(ZCD_NV_BATTERY_FORECAST, 0, sizeof(BatteryForecastState_t), &forecast) == SUCCESS) {
+        LREP("Battery forecast: trend=%d/256 mV/day charge=%ld uAs/day periods=%d\r\n", forecast.trendRate,
+             forecast.dailyCharge, forecast.periods);
+    }
+    forecast_lastTick = osal_GetSystemClock();
+}
+
+void zclBatteryForecast_CountActivity(uint8 activity) {
+    switch (activity) {
+    case BATTERY_ACTIVITY_TX_FRAME:
+        forecast_periodCharge += BATTERY_FORECAST_COST_TX_FRAME;
+        break;
+    case BATTERY_ACTIVITY_POLL:
+        forecast_periodCharge += BATTERY_FORECAST_COST_POLL;
+        break;
+    case BATTERY_ACTIVITY_SENSOR_CONVERSION:
+        forecast_periodCharge += BATTERY_FORECAST_COST_SENSOR_CONVERSION;
+        break;
+    default:
+        break;
+    }
+}
+
+void zclBatteryForecast_AddAwakeTime(uint16 ms) { forecast_periodCharge += (uint32)ms * BATTERY_FORECAST_COST_AWAKE_MS; }
+
+// Charge per day implied by the current (partial) period, uA*s
+static uint32 zclBatteryForecast_CurrentDailyCharge(void) {
+    uint32 minutes = forecast_periodSeconds / 60;
+    if (minutes < 60) {
+        return forecast.dailyCharge; // under an hour of data - too noisy
+    }
+    return (forecast_periodCharge / minutes) * 1440;
+}
+
+static void zclBatteryForecast_ClosePeriod(void) {
+    uint32 periodDaily = zclBatteryForecast_CurrentDailyCharge();
+    uint32 drop = (forecast.anchorMv > forecast_smoothedMv) ? (forecast.anchorMv - forecast_smoothedMv) : 0;
+    uint32 rate = drop * BATTERY_FORECAST_Q * (BATTERY_FORECAST_PERIOD_SEC / 60) / (forecast_periodSeconds / 60);
+
+    if (forecast.periods == 0) {
+        forecast.trendRate = (uint16)MIN(rate, 0xFFFF);
+        forecast.dailyCharge = periodDaily;
+    } else {
+        // EWMA, alpha = 1/4
+        forecast.trendRate = (uint16)MIN((3 * (uint32)forecast.trendRate + rate) >> 2, 0xFFFF);
+        forecast.dailyCharge = (3 * forecast.dailyCharge + periodDaily) >> 2;
+    }
+    if (forecast.periods < 0xFF) {
+        forecast.periods++;
+    }
+    forecast.anchorMv = forecast_smoothedMv;
+    forecast_periodSeconds = 0;
+    forecast_periodCharge = 0;
+    zclBatteryForecast_Save();
+}
+
+static uint16 zclBatteryForecast_Estimate(uint8 percentageZCL) {
+    uint32 days = BATTERY_FORECAST_DAYS_UNKNOWN;
+    uint32 daily = zclBatteryForecast_CurrentDailyCharge();
+
+    if (daily > 0) {
+        days = ((uint32)percentageZCL * BATTERY_FORECAST_UAS_PER_ZCL_PERCENT) / daily;
+    }
+
+    if (forecast.periods >= BATTERY_FORECAST_MIN_PERIODS && forecast.trendRate > 0) {
+        uint32 headroom = (forecast_smoothedMv > BATTERY_FORECAST_CUTOFF_MV) ? (forecast_smoothedMv - BATTERY_FORECAST_CUTOFF_MV) : 0;
+        uint32 trendDays = headroom * BATTERY_FORECAST_Q / forecast.trendRate;
+        // Trend was learned at the historic activity level; busier now means faster drain
+        if (daily > forecast.dailyCharge && forecast.dailyCharge > 0) {
+            trendDays = trendDays * (forecast.dailyCharge >> 8) / ((daily >> 8) + 1);
+        }
+        days = MIN(days, trendDays);
+    }
+
+    return (uint16)MIN(days, BATTERY_FORECAST_DAYS_UNKNOWN - 1);
+}
+
+void zclBatteryForecast_Update(uint16 millivolts, uint8 percentageZCL) {
+    // Monotonic ms tick, not osal_getClock(): setting UTC from the Time cluster would make one
+    // period span decades. Whole seconds only - the remainder carries into the next update.
+    uint32 elapsed = (osal_GetSystemClock() - forecast_lastTick) / 1000;
+    forecast_lastTick += elapsed * 1000;
+    forecast_periodSeconds += elapsed;
+    forecast_periodCharge += elapsed * BATTERY_FORECAST_SLEEP_UA;
+    forecast_periodCharge += pollArbiter_TakePollCount() * BATTERY_FORECAST_COST_POLL;
+
+    if (forecast_smoothedMv == 0) {
+        forecast_smoothedMv = millivolts;
+    } else {
+        // EWMA, alpha = 1/8 - flattens TX sag noise
+        forecast_smoothedMv = (uint16)((7 * (uint32)forecast_smoothedMv + millivolts) >> 3);
+    }
+    if (forecast.anchorMv == 0) {
+        forecast.anchorMv = forecast_smoothedMv;
+    }
+
+    if (forecast_periodSeconds >= BATTERY_FORECAST_PERIOD_SEC) {
+        zclBatteryForecast_ClosePeriod();
+    }
+
+    zclBattery_DaysRemaining = zclBatteryForecast_Estimate(percentageZCL);
+    LREP("Battery forecast: smoothed=%d mV days=%d\r\n", forecast_smoothedMv, zclBattery_DaysRemaining);
+}
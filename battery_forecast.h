@@ -0,0 +1,28 @@
+#ifndef _BATTERY_FORECAST_H
+#define _BATTERY_FORECAST_H
+
+#include "hal_types.h"
+
+// Custom POWER_CFG attribute: estimated days until the cell reaches cutoff (0xFFFF = unknown)
+#define ATTRID_POWER_CFG_BATTERY_DAYS_REMAINING                 0x0202
+
+#define ZCD_NV_BATTERY_FORECAST 0x0409
+
+#define BATTERY_FORECAST_DAYS_UNKNOWN 0xFFFF
+
+// Energy-costly activities counted by the forecaster
+#define BATTERY_ACTIVITY_TX_FRAME          0
+#define BATTERY_ACTIVITY_POLL              1
+#define BATTERY_ACTIVITY_SENSOR_CONVERSION 2
+
+extern uint16 zclBattery_DaysRemaining;
+
+extern void zclBatteryForecast_Init(void);
+// Feed one voltage sample (loaded mV when available) and the ZCL percentage (0-200)
+extern void zclBatteryForecast_Update(uint16 millivolts, uint8 percentageZCL);
+// Library paths already count TX frames (zclCommissioning_OnTxConfirm), polls (poll arbiter) and
+// DS18B20 conversions; call these from other sensor drivers (awake time = blocking waits)
+extern void zclBatteryForecast_CountActivity(uint8 activity);
+extern void zclBatteryForecast_AddAwakeTime(uint16 ms);
+
+#endif
@@ -1,30 +1,45 @@
 #include "commissioning.h"
+#include "backoff.h"
+#include "battery.h"
+#include "battery_forecast.h"
+#include "diagnostics.h"
 #include "Debug.h"
 #include "OSAL.h"
 #include "OSAL_PwrMgr.h"
 #include "ZDApp.h"
+#include "ZDObject.h"
+#include "bdb.h"
 #include "bdb_interface.h"
 #include "hal_key.h"
 #include "hal_led.h"
 #include "led_breathing.h"
+#include "nv_state.h"
+#include "poll_arbiter.h"
+#include "power_profile.h"
+#include "report_frame.h"
+#include "report_queue.h"
+#include "wake_scheduler.h"
 #include "nwk_globals.h"
+#include "ZGlobals.h"
+#include "AddrMgr.h"
+#include "BindingTable.h"
+#include "APSMEDE.h"
+#include "AF.h"
 #include "zcl_app.h"  // For TX power mode access
 #include "ZMAC.h"     // For TX_PWR constants
 
 static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_t *bdbCommissioningModeMsg);
 static void zclCommissioning_ResetBackoffRetry(void);
 static void zclCommissioning_BindNotification(bdbBindNotificationData_t *data);
+static void zclCommissioning_FilterNwkDesc(networkDesc_t *pBDBListNwk, uint8 count);
+static void zclCommissioning_ClearCandidates(void);
+static void zclCommissioning_ExtendInterview(void);
+static bool zclCommissioning_ScheduleParentSwitch(uint8 reason);
 extern bool requestNewTrustCenterLinkKey;
 
 // External TX power mode from zcl_app.c
 extern uint8 zclApp_TxPowerMode;
 
-// Issue #24: Persist rejoin backoff state across power cycles
-typedef struct {
-    byte rejoinsLeft;
-    uint32 rejoinDelay;
-} RejoinBackoffState_t;
-
 byte rejoinsLeft = APP_COMMISSIONING_END_DEVICE_REJOIN_TRIES;
 uint32 rejoinDelay = APP_COMMISSIONING_END_DEVICE_REJOIN_START_DELAY;
 
@@ -33,39 +48,124 @@ uint8 zclCommissioning_TaskId = 0;
 // Hybrid Phase 2: Network Quality Metrics (typedef moved to header)
 NetworkMetrics_t network_metrics = {0}; // Non-static for ZCL access
 bool zclCommissioning_interviewActive = false; // Non-static: app checks before post-report poll revert
+
+// Interview window: join time, last interview request and the hard-cap deadline (osal_GetSystemClock)
+static uint32 interview_start = 0;
+static uint32 interview_last = 0;
+static uint32 interview_request = 0; // last coordinator request seen (not a reply confirm)
+static uint32 interview_deadline = 0;
 static int8 current_tx_power = 0; // Start at 0 dBm (TX_PWR_0_DBM) to save battery — int8 matches NetworkMetrics_t.current_tx_power
-static bool quick_rejoin_attempted = false;
+
+// Closed-loop TX power state
+static uint16 link_lqi_ewma = 0;  // parent LQI << 4, alpha 1/8 (0 = no sample yet)
+static uint8 txpwr_window_frames = 0;
+static uint8 txpwr_window_failures = 0;
+static int8 txpwr_trend = 0;      // +n: n windows asking for more power, -n: less
+static bool txpwr_fed = false;    // a link sample or TX confirm has reached the loop
+
+// Proactive parent switching
+static uint8 link_weak_samples = 0;
+#define PARENT_SWITCH_IDLE      0
+#define PARENT_SWITCH_SCHEDULED 1 // waiting for the idle window
+#define PARENT_SWITCH_STARTED   2 // bdb_parentLost() called, the next PARENT_LOST is ours
+static uint8 parent_switch_state = PARENT_SWITCH_IDLE;
+static uint32 parent_switch_last = 0;
+static uint16 parent_switch_from = INVALID_NODE_ADDR; // parent we left, until the rejoin settles
+static uint8 parent_switch_misses = 0; // switches in a row that came back to the same parent
+
+// Candidate-parent table lives in the NV record (nvState.candidates); candidate used by the rejoin in flight
+static uint8 rejoin_candidate = 0xFF;
+
+// NV write-back: the record changed in RAM but is not written yet (it is always saved whole)
+static bool nv_dirty = false;
+// Channel-targeted rejoin: attempts made on the cached channel before widening the scan
+static uint8 quick_rejoin_attempts = 0;
+static uint32 rejoin_attempt_start = 0; // 0 = no rejoin attempt in flight
+static uint16 rejoin_cache_pan_id = 0xFFFF;
+static uint16 rejoin_cache_parent = INVALID_NODE_ADDR;
 
 // Aqara-style LED behavior: track if we're in user-initiated pairing mode
 static bool pairing_mode_active = false;
 
+// Offline report queue flush retries left since the last join or rejoin
+static uint8 queue_retries_left = 0;
+
 // Join-success 3-flash state machine (100ms ON/OFF × 3)
 static uint8 join_flash_counter = 0;
 
 // Boot-time join retry: keep retrying every 30s during the 5-minute pairing window
 #define APP_COMMISSIONING_JOIN_RETRY_INTERVAL ((uint32)30000)  // 30 seconds between join attempts
 
+// Rejoin attempts restricted to the last known channel before falling back to the full channel list
+#ifndef APP_COMMISSIONING_QUICK_REJOIN_ATTEMPTS
+    #define APP_COMMISSIONING_QUICK_REJOIN_ATTEMPTS 2
+#endif
+
 #ifndef APP_TX_POWER
     #define APP_TX_POWER 4  // TX_PWR_PLUS_4 (+4 dBm)
 #endif
 
+// Closed-loop TX power (auto mode): lowest power the controller may step down to
+#ifndef APP_TX_POWER_MIN
+    #define APP_TX_POWER_MIN 0  // TX_PWR_0_DBM; negative values allowed on CC2530
+#endif
+
+// Smoothed parent LQI thresholds - the gap between them is the hysteresis band
+#ifndef APP_TX_POWER_LQI_LOW
+    #define APP_TX_POWER_LQI_LOW 90
+#endif
+
+#ifndef APP_TX_POWER_LQI_HIGH
+    #define APP_TX_POWER_LQI_HIGH 170
+#endif
+
+// Frames per evaluation window and failed frames in a window that force a step up
+#define APP_TX_POWER_WINDOW 8
+#define APP_TX_POWER_FAIL_LIMIT 2
+// Consecutive windows pointing the same way before a step is taken
+#define APP_TX_POWER_CONFIRM_WINDOWS 2
+
 /*********************************************************************
  * HYBRID PHASE 2: HELPER FUNCTIONS
  */
 
 /*********************************************************************
- * @fn      zclCommissioning_SaveBackoffState
- * @brief   Save rejoin backoff state to NV memory (Issue #24)
+ * @fn      zclCommissioning_NvMarkDirty
+ * @brief   Defer an NV write. The staleness timer is armed only when the
+ *          record first goes dirty, so later changes never push it out.
  * @param   none
  * @return  none
  */
-static void zclCommissioning_SaveBackoffState(void) {
-    RejoinBackoffState_t state;
-    state.rejoinsLeft = rejoinsLeft;
-    state.rejoinDelay = rejoinDelay;
+static void zclCommissioning_NvMarkDirty(void) {
+    if (!nv_dirty) {
+        // Any wakeup in the last quarter of the staleness bound will do
+        wakeScheduler_Start(zclCommissioning_TaskId, APP_COMMISSIONING_NV_FLUSH_EVT,
+                            APP_COMMISSIONING_NV_MAX_STALENESS - APP_COMMISSIONING_NV_MAX_STALENESS / 4,
+                            APP_COMMISSIONING_NV_MAX_STALENESS / 4);
+    }
+    nv_dirty = true;
+}
 
-    osal_nv_item_init(ZCD_NV_REJOIN_BACKOFF_STATE, sizeof(RejoinBackoffState_t), &state);
-    osal_nv_write(ZCD_NV_REJOIN_BACKOFF_STATE, 0, sizeof(RejoinBackoffState_t), &state);
+/*********************************************************************
+ * @fn      zclCommissioning_NvFlush
+ * @brief   Copy the RAM state into the NV record and write it in one
+ *          NV access (metrics, last channel, backoff - Issue #24 - and
+ *          candidates share the record, see nv_state.h)
+ * @param   none
+ * @return  none
+ */
+void zclCommissioning_NvFlush(void) {
+    if (!nv_dirty) {
+        return;
+    }
+    wakeScheduler_Stop(zclCommissioning_TaskId, APP_COMMISSIONING_NV_FLUSH_EVT);
+    LREPMaster("NV flush\r\n");
+
+    osal_memcpy(&nvState.metrics, &network_metrics, sizeof(NetworkMetrics_t));
+    nvState.backoff.rejoinsLeft = rejoinsLeft;
+    nvState.backoff.rejoinDelay = rejoinDelay;
+    nvState_Save();
+    nv_dirty = false;
 }
 
 /*********************************************************************
@@ -76,45 +176,40 @@ static void zclCommissioning_SaveBackoffState(void) {
  */
 void zclCommissioning_StartPairingMode(void) {
     pairing_mode_active = true;
-    osal_stop_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT);
-    osal_stop_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_POLL_NORMAL_EVT);
+    wakeScheduler_Stop(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT);
 
     // OSAL-safe blink: 1Hz toggle via led_breathing (no HAL timer — safe for SED sleep)
     led_breathing_start();
 
-#if defined(POWER_SAVING)
-    NLME_SetPollRate(QUEUED_POLL_RATE);
-#endif
+    pollArbiter_Request(POLL_CLIENT_PAIRING, QUEUED_POLL_RATE, POLL_PRIORITY_HIGH, APP_COMMISSIONING_PAIRING_TIMEOUT);
 
     LREP("Pairing mode: LED blinking\r\n");
-    osal_start_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_PAIRING_TIMEOUT_EVT, APP_COMMISSIONING_PAIRING_TIMEOUT);
+    wakeScheduler_Start(zclCommissioning_TaskId, APP_COMMISSIONING_PAIRING_TIMEOUT_EVT, APP_COMMISSIONING_PAIRING_TIMEOUT,
+                        APP_COMMISSIONING_PAIRING_TIMEOUT / 64);
 }
 
 void zclCommissioning_ResetState(void) {
     // Reset metrics and backoff state to allow immediate rejoin after factory reset
     osal_memset(&network_metrics, 0, sizeof(NetworkMetrics_t));
-    osal_nv_item_init(ZCD_NV_NETWORK_METRICS, sizeof(NetworkMetrics_t), &network_metrics);
-    osal_nv_write(ZCD_NV_NETWORK_METRICS, 0, sizeof(NetworkMetrics_t), &network_metrics);
 
-    uint8 last_channel = 0;
-    osal_nv_item_init(ZCD_NV_LAST_CHANNEL, 1, &last_channel);
-    osal_nv_write(ZCD_NV_LAST_CHANNEL, 0, 1, &last_channel);
+    // Candidates belong to the old network
+    zclCommissioning_ClearCandidates();
+    nvState.last_channel = 0;
 
-    RejoinBackoffState_t state;
-    state.rejoinsLeft = APP_COMMISSIONING_END_DEVICE_REJOIN_TRIES;
-    state.rejoinDelay = APP_COMMISSIONING_END_DEVICE_REJOIN_START_DELAY;
-    osal_nv_item_init(ZCD_NV_REJOIN_BACKOFF_STATE, sizeof(RejoinBackoffState_t), &state);
-    osal_nv_write(ZCD_NV_REJOIN_BACKOFF_STATE, 0, sizeof(RejoinBackoffState_t), &state);
-
-    // Reset in-memory backoff as well
     rejoinsLeft = APP_COMMISSIONING_END_DEVICE_REJOIN_TRIES;
     rejoinDelay = APP_COMMISSIONING_END_DEVICE_REJOIN_START_DELAY;
-    quick_rejoin_attempted = false;
+    quick_rejoin_attempts = 0;
+    rejoin_attempt_start = 0;
+    zgDefaultChannelList = DEFAULT_CHANLIST;
+
+    // Factory reset is a critical transition - write everything out now
+    zclCommissioning_NvMarkDirty();
+    zclCommissioning_NvFlush();
 }
 
 /*********************************************************************
  * @fn      zclCommissioning_AdaptiveTxPower
- * @brief   Adjust TX power based on join success/failure
+ * @brief   Step TX power by 1 dB within [APP_TX_POWER_MIN, APP_TX_POWER]
  * @param   increase - true to increase power, false to decrease
  * @return  none
  */
@@ -126,16 +221,181 @@ static void zclCommissioning_AdaptiveTxPower(bool increase) {
         return;
     }
 
-    if (increase && current_tx_power < 4) {  // 4 = TX_PWR_PLUS_4 (+4 dBm)
+    if (increase && current_tx_power < APP_TX_POWER) {
         current_tx_power++;
-        ZMacSetTransmitPower(current_tx_power);
-        LREP("Increased TX power to +%d dBm\r\n", current_tx_power);
-        network_metrics.current_tx_power = current_tx_power;
-    } else if (!increase && current_tx_power > 0) {  // 0 = TX_PWR_0_DBM (0 dBm)
-        current_tx_power = 0; // Reset to minimum (0 dBm)
-        ZMacSetTransmitPower(current_tx_power);
-        LREP("Reset TX power to 0 dBm\r\n");
-        network_metrics.current_tx_power = current_tx_power;
+    } else if (!increase && current_tx_power > APP_TX_POWER_MIN) {
+        current_tx_power--;
+    } else {
+        return;
+    }
+    ZMacSetTransmitPower(current_tx_power);
+    LREP("TX power %s to %d dBm (lqi=%d)\r\n", increase ? "raised" : "lowered", current_tx_power, link_lqi_ewma >> 4);
+    network_metrics.current_tx_power = current_tx_power;
+    txpwr_trend = 0;
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_EvaluateTxPower
+ * @brief   Closed-loop controller: once per window of TX frames, vote for
+ *          more power on a high failure rate or weak smoothed LQI, less on
+ *          a clean window with strong LQI. A step needs
+ *          APP_TX_POWER_CONFIRM_WINDOWS consecutive votes (hysteresis).
+ * @param   none
+ * @return  none
+ */
+static void zclCommissioning_EvaluateTxPower(void) {
+    uint8 lqi = (uint8)(link_lqi_ewma >> 4);
+    int8 vote = 0;
+
+    if (txpwr_window_failures >= APP_TX_POWER_FAIL_LIMIT || (link_lqi_ewma != 0 && lqi < APP_TX_POWER_LQI_LOW)) {
+        vote = 1;
+    } else if (txpwr_window_failures == 0 && lqi > APP_TX_POWER_LQI_HIGH) {
+        vote = -1;
+    }
+
+    txpwr_window_frames = 0;
+    txpwr_window_failures = 0;
+
+    if (vote == 0 || (vote > 0) != (txpwr_trend > 0)) {
+        txpwr_trend = vote; // direction changed or link in the dead band - start over
+    } else {
+        txpwr_trend += vote;
+    }
+
+    if (txpwr_trend >= APP_TX_POWER_CONFIRM_WINDOWS) {
+        zclCommissioning_AdaptiveTxPower(true);
+    } else if (txpwr_trend <= -APP_TX_POWER_CONFIRM_WINDOWS) {
+        zclCommissioning_AdaptiveTxPower(false);
+    }
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_CheckLinkEstimate
+ * @brief   Schedule a controlled parent switch once the smoothed link
+ *          estimate stays weak for APP_COMMISSIONING_PARENT_SWITCH_SAMPLES
+ * @param   reason - PARENT_SWITCH_REASON_* of the latest weakening input
+ * @return  none
+ */
+static void zclCommissioning_CheckLinkEstimate(uint8 reason) {
+    if ((link_lqi_ewma >> 4) >= APP_COMMISSIONING_PARENT_SWITCH_LQI) {
+        link_weak_samples = 0;
+        return;
+    }
+    if (link_weak_samples < 0xFF) {
+        link_weak_samples++;
+    }
+    if (link_weak_samples >= APP_COMMISSIONING_PARENT_SWITCH_SAMPLES) {
+        zclCommissioning_ScheduleParentSwitch(reason);
+    }
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_ScheduleParentSwitch
+ * @brief   Arm a controlled parent switch unless one is pending or the
+ *          last one was too recent
+ * @param   reason - PARENT_SWITCH_REASON_*
+ * @return  true if scheduled
+ */
+static bool zclCommissioning_ScheduleParentSwitch(uint8 reason) {
+    if (parent_switch_state != PARENT_SWITCH_IDLE) {
+        return false;
+    }
+    // Each switch that landed on the same parent doubles the wait before the next try
+    uint32 minInterval = APP_COMMISSIONING_PARENT_SWITCH_MIN_INTERVAL << parent_switch_misses;
+    if (parent_switch_last != 0 && (osal_GetSystemClock() - parent_switch_last) < minInterval) {
+        return false;
+    }
+
+    parent_switch_state = PARENT_SWITCH_SCHEDULED;
+    network_metrics.last_switch_reason = reason;
+    osal_start_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_PARENT_SWITCH_EVT, APP_COMMISSIONING_PARENT_SWITCH_IDLE_DELAY);
+    return true;
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_StartParentSwitch
+ * @brief   Drop the weak parent and rejoin through the normal recovery
+ *          path (cached channel first) - only in an idle window
+ * @param   none
+ * @return  none
+ */
+static void zclCommissioning_StartParentSwitch(void) {
+    if (devState != DEV_END_DEVICE || zclCommissioning_interviewActive || pairing_mode_active) {
+        // Busy - retry on the next weak sample instead
+        parent_switch_state = PARENT_SWITCH_IDLE;
+        return;
+    }
+
+    parent_switch_state = PARENT_SWITCH_STARTED;
+    parent_switch_last = osal_GetSystemClock();
+    parent_switch_from = _NIB.nwkCoordAddress; // counted as a switch only if we end up elsewhere
+    LREP("Proactive parent switch from 0x%X (lqi=%d reason=%d)\r\n", parent_switch_from, link_lqi_ewma >> 4,
+         network_metrics.last_switch_reason);
+
+    // Same entry ZDApp uses on MAC sync loss - BDB reports PARENT_LOST and recovery starts
+    bdb_parentLost();
+}
+
+void zclCommissioning_OnLinkSample(uint8 lqi) {
+    txpwr_fed = true;
+    network_metrics.parent_lqi = lqi;
+    if (link_lqi_ewma == 0) {
+        link_lqi_ewma = (uint16)lqi << 4;
+    } else {
+        link_lqi_ewma = link_lqi_ewma - (link_lqi_ewma >> 3) + ((uint16)lqi << 1);
+    }
+    zclCommissioning_CheckLinkEstimate(PARENT_SWITCH_REASON_LOW_LQI);
+}
+
+void zclCommissioning_OnPollConfirm(uint8 status) {
+    pollArbiter_OnPollConfirm(status);
+    zclBattery_SampleLoaded();
+    // Data or an empty queue both mean the parent answered
+    if (status == ZSuccess || status == ZMacNoData || link_lqi_ewma == 0) {
+        return;
+    }
+    // A failed poll is a strong signal: pull the estimate down by 1/4 towards zero
+    link_lqi_ewma -= link_lqi_ewma >> 2;
+    zclCommissioning_CheckLinkEstimate(PARENT_SWITCH_REASON_POLL_FAILURES);
+}
+
+void zclCommissioning_OnTxConfirm(uint8 status) {
+    txpwr_fed = true;
+    zclBatteryForecast_CountActivity(BATTERY_ACTIVITY_TX_FRAME);
+    zclBattery_SampleLoaded(); // cell still recovering from the TX burst
+    // Replies to the coordinator's reads only show up as confirms - anything else we send doesn't
+    // keep the interview window open
+    if (zclCommissioning_interviewActive && interview_request != 0 &&
+        (osal_GetSystemClock() - interview_request) < APP_COMMISSIONING_INTERVIEW_REPLY_WINDOW) {
+        zclCommissioning_ExtendInterview();
+    }
+    uint8 probeFailures = zclReportFrame_OnConfirm(status);
+    if (status == ZApsNoAck) {
+        // The parent took the frame; the end-to-end ACK is missing (e.g. coordinator down, or a
+        // parent that lost its route). More TX power doesn't fix that - the probe repeats sooner,
+        // and a run of failures tries the path through a rejoin, which also resends queued history
+        if (network_metrics.aps_ack_failures < 0xFFFF) {
+            network_metrics.aps_ack_failures++;
+        }
+        if (probeFailures >= APP_COMMISSIONING_PROBE_FAILURES &&
+            zclCommissioning_ScheduleParentSwitch(PARENT_SWITCH_REASON_NO_APS_ACK)) {
+            LREP("No APS ACK %d times in a row - rejoin check\r\n", probeFailures);
+            zclReportFrame_ResetProbe();
+        }
+        return;
+    }
+    txpwr_window_frames++;
+    if (status != ZSuccess) {
+        txpwr_window_failures++;
+    }
+    if (txpwr_window_frames >= APP_TX_POWER_WINDOW || txpwr_window_failures >= APP_TX_POWER_FAIL_LIMIT) {
+        zclCommissioning_EvaluateTxPower();
+    }
+    // Parent never MAC-ACKed the frame after all retries - polls can keep working in that
+    // state, so halve the estimate towards a switch
+    if (status == ZMacNoACK && link_lqi_ewma != 0) {
+        link_lqi_ewma >>= 1;
+        zclCommissioning_CheckLinkEstimate(PARENT_SWITCH_REASON_NO_MAC_ACK);
     }
 }
 
@@ -151,45 +411,270 @@ static void zclCommissioning_UpdateNetworkQuality(void) {
 
     // Save current channel
     network_metrics.last_channel = _NIB.nwkLogicalChannel;
+    rejoin_cache_pan_id = _NIB.nwkPanId;
+    rejoin_cache_parent = _NIB.nwkCoordAddress;
 
     LREP("Network quality: LQI=%d Channel=%d\r\n",
          network_metrics.parent_lqi,
          network_metrics.last_channel);
 
-    // Save metrics to NV
-    osal_nv_item_init(ZCD_NV_NETWORK_METRICS, sizeof(NetworkMetrics_t), &network_metrics);
-    osal_nv_write(ZCD_NV_NETWORK_METRICS, 0, sizeof(NetworkMetrics_t), &network_metrics);
+    // Metrics and channel go out with the next flush
+    nvState.last_channel = network_metrics.last_channel;
+    zclCommissioning_NvMarkDirty();
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_CandidateScore
+ * @brief   Rank a candidate parent: link quality minus a per-hop penalty
+ * @param   cand - candidate entry
+ * @return  score, 0 if unusable
+ */
+static uint8 zclCommissioning_CandidateScore(ParentCandidate_t *cand) {
+    if (cand->short_addr == INVALID_NODE_ADDR || !(cand->flags & PARENT_CANDIDATE_FLAG_DEVICE_CAPACITY)) {
+        return 0;
+    }
+    uint8 penalty = (cand->depth > 15) ? 0xFF : (uint8)(cand->depth << 3);
+    return (cand->lqi > penalty) ? (cand->lqi - penalty) : 1;
+}
+
+void zclCommissioning_OnBeacon(uint16 shortAddr, uint8 *extPanId, uint8 channel, uint8 lqi, uint8 depth, uint8 flags) {
+    uint8 slot = 0xFF;
+    uint8 worst = 0xFF;
+    uint8 i;
+
+    for (i = 0; i < APP_COMMISSIONING_PARENT_CANDIDATES; i++) {
+        ParentCandidate_t *cand = &nvState.candidates[i];
+        if (cand->short_addr == shortAddr && osal_memcmp(cand->ext_pan_id, extPanId, Z_EXTADDR_LEN)) {
+            slot = i; // refresh the existing entry
+            break;
+        }
+        uint8 score = zclCommissioning_CandidateScore(cand);
+        if (score < worst) {
+            worst = score;
+            slot = i;
+        }
+    }
+
+    ParentCandidate_t entry = {shortAddr, {0}, channel, lqi, depth, flags};
+    osal_memcpy(entry.ext_pan_id, extPanId, Z_EXTADDR_LEN);
+    if (i == APP_COMMISSIONING_PARENT_CANDIDATES && zclCommissioning_CandidateScore(&entry) <= worst) {
+        return; // table full of better candidates
+    }
+    nvState.candidates[slot] = entry;
+}
+
+#ifdef APP_COMMISSIONING_EXT_PAN_ALLOW_LIST
+static const uint8 zclCommissioning_ExtPanAllowList[][Z_EXTADDR_LEN] = {APP_COMMISSIONING_EXT_PAN_ALLOW_LIST};
+
+static bool zclCommissioning_ExtPanAllowed(uint8 *extPanId) {
+    for (uint8 i = 0; i < sizeof(zclCommissioning_ExtPanAllowList) / Z_EXTADDR_LEN; i++) {
+        if (osal_memcmp(extPanId, (void *)zclCommissioning_ExtPanAllowList[i], Z_EXTADDR_LEN)) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+static void zclCommissioning_FilterNwkDesc(networkDesc_t *pBDBListNwk, uint8 count) {
+    networkDesc_t *desc = pBDBListNwk;
+    while (desc != NULL && count--) {
+        networkDesc_t *next = desc->nextDesc;
+#ifdef APP_COMMISSIONING_EXT_PAN_ALLOW_LIST
+        if (!zclCommissioning_ExtPanAllowed(desc->extendedPANID)) {
+            LREP("Skipping foreign network 0x%X on channel %d\r\n", desc->panId, desc->logicalChannel);
+            bdb_nwkDescFree(desc); // BDB will not try to join it
+            desc = next;
+            continue;
+        }
+#endif
+        uint8 flags = (desc->routerCapacity ? PARENT_CANDIDATE_FLAG_ROUTER_CAPACITY : 0) |
+                      (desc->deviceCapacity ? PARENT_CANDIDATE_FLAG_DEVICE_CAPACITY : 0);
+        zclCommissioning_OnBeacon(desc->chosenRouter, desc->extendedPANID, desc->logicalChannel, desc->chosenRouterLinkQuality,
+                                  desc->chosenRouterDepth, flags);
+        desc = next;
+    }
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_StartSteering
+ * @brief   Start BDB commissioning with tiered channel sets: preferred
+ *          channels plus the last known one as primary, everything else
+ *          in DEFAULT_CHANLIST as secondary
+ * @param   none
+ * @return  none
+ */
+static void zclCommissioning_StartSteering(void) {
+    uint32 primary = APP_COMMISSIONING_PREFERRED_CHANNELS;
+    if (nvState.last_channel >= 11 && nvState.last_channel <= 26) {
+        primary |= (uint32)1 << nvState.last_channel;
+    }
+    primary &= DEFAULT_CHANLIST;
+    bdb_setChannelAttribute(TRUE, primary);
+    bdb_setChannelAttribute(FALSE, DEFAULT_CHANLIST & ~primary);
+    LREP("Steering: primary 0x%lX secondary 0x%lX\r\n", primary, DEFAULT_CHANLIST & ~primary);
+
+#if APP_COMMISSIONING_JOIN_PROFILE == APP_COMMISSIONING_JOIN_PROFILE_FULL
+    bdb_StartCommissioning(BDB_COMMISSIONING_MODE_NWK_STEERING | BDB_COMMISSIONING_MODE_FINDING_BINDING);
+#else
+    // No Finding & Binding: no identify window or F&B traffic after the join
+    bdb_StartCommissioning(BDB_COMMISSIONING_MODE_NWK_STEERING);
+#endif
+}
+
+#if APP_COMMISSIONING_JOIN_PROFILE == APP_COMMISSIONING_JOIN_PROFILE_COORD_BIND
+/*********************************************************************
+ * @fn      zclCommissioning_BindCoordinator
+ * @brief   Bind APP_COMMISSIONING_COORD_BIND_CLUSTERS to the coordinator
+ *          (trust center) - the one binding F&B would have produced,
+ *          without the identify round trips. Existing bindings are kept.
+ * @param   none
+ * @return  none
+ */
+static void zclCommissioning_BindCoordinator(void) {
+    static const uint16 clusters[] = {APP_COMMISSIONING_COORD_BIND_CLUSTERS};
+    uint8 tcAddr[Z_EXTADDR_LEN];
+    bool added = false;
+
+    APSME_GetRequest(apsTrustCenterAddress, 0, tcAddr);
+    if (osal_isbufset(tcAddr, 0x00, Z_EXTADDR_LEN) || osal_isbufset(tcAddr, 0xFF, Z_EXTADDR_LEN)) {
+        LREP("Coordinator bind skipped: trust center address unknown\r\n");
+        return;
+    }
+
+    // Coordinator is always 0x0000 - seed the address manager so APS needs no address lookup
+    AddrMgrEntry_t entry;
+    entry.user = ADDRMGR_USER_DEFAULT;
+    entry.nwkAddr = 0x0000;
+    osal_memcpy(entry.extAddr, tcAddr, Z_EXTADDR_LEN);
+    AddrMgrEntryUpdate(&entry);
+
+    zAddrType_t dst;
+    dst.addrMode = Addr64Bit;
+    osal_memcpy(dst.addr.extAddr, tcAddr, Z_EXTADDR_LEN);
+
+    for (uint8 i = 0; i < sizeof(clusters) / sizeof(clusters[0]); i++) {
+        if (bindFind(APP_COMMISSIONING_COORD_BIND_SRC_ENDPOINT, clusters[i], 0) != NULL) {
+            continue;
+        }
+        uint16 cluster = clusters[i];
+        if (bindAddEntry(APP_COMMISSIONING_COORD_BIND_SRC_ENDPOINT, &dst, APP_COMMISSIONING_COORD_BIND_DST_ENDPOINT, 1,
+                         &cluster) != NULL) {
+            added = true;
+        }
+    }
+    if (added) {
+        BindWriteNV();
+        LREP("Bound %d cluster(s) to coordinator\r\n", (int)(sizeof(clusters) / sizeof(clusters[0])));
+    }
+}
+#endif
 
-    // Save last successful channel separately for quick access
-    osal_nv_item_init(ZCD_NV_LAST_CHANNEL, 1, &network_metrics.last_channel);
-    osal_nv_write(ZCD_NV_LAST_CHANNEL, 0, 1, &network_metrics.last_channel);
+static void zclCommissioning_ClearCandidates(void) {
+    for (uint8 i = 0; i < APP_COMMISSIONING_PARENT_CANDIDATES; i++) {
+        osal_memset(&nvState.candidates[i], 0, sizeof(ParentCandidate_t));
+        nvState.candidates[i].short_addr = INVALID_NODE_ADDR;
+    }
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_BestCandidate
+ * @brief   Best-ranked candidate on our network, other than the parent
+ *          we just lost
+ * @param   none
+ * @return  index into nvState.candidates, 0xFF if none
+ */
+static uint8 zclCommissioning_BestCandidate(void) {
+    uint8 best = 0xFF;
+    uint8 bestScore = 0;
+    for (uint8 i = 0; i < APP_COMMISSIONING_PARENT_CANDIDATES; i++) {
+        ParentCandidate_t *cand = &nvState.candidates[i];
+        if (cand->short_addr == _NIB.nwkCoordAddress || cand->channel < 11 || cand->channel > 26 ||
+            !osal_memcmp(cand->ext_pan_id, _NIB.extendedPANID, Z_EXTADDR_LEN)) {
+            continue;
+        }
+        uint8 score = zclCommissioning_CandidateScore(cand);
+        if (score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+    return best;
 }
 
 /*********************************************************************
  * @fn      zclCommissioning_QuickRejoin
- * @brief   Try to rejoin on last successful channel first (fast path)
+ * @brief   Restrict the next rejoin to the last successful channel, PAN ID
+ *          and parent (fast path). Widens to DEFAULT_CHANLIST after
+ *          APP_COMMISSIONING_QUICK_REJOIN_ATTEMPTS failed attempts.
  * @param   none
- * @return  true if quick rejoin attempted
+ * @return  true if the rejoin is channel-targeted
  */
 static bool zclCommissioning_QuickRejoin(void) {
-    uint8 last_channel = 0;
-
-    // Read last successful channel from NV
-    if (osal_nv_read(ZCD_NV_LAST_CHANNEL, 0, 1, &last_channel) == SUCCESS) {
-        if (last_channel >= 11 && last_channel <= 26) {
-            LREP("Quick rejoin attempt on channel %d\r\n", last_channel);
+    uint8 last_channel = network_metrics.last_channel;
+
+    // First attempt: scan only the channel of the best cached candidate parent. The stack still
+    // picks the parent from the beacons it hears there - the NIB parent address doesn't steer it.
+    rejoin_candidate = (quick_rejoin_attempts == 0) ? zclCommissioning_BestCandidate() : 0xFF;
+    if (rejoin_candidate != 0xFF) {
+        ParentCandidate_t *cand = &nvState.candidates[rejoin_candidate];
+        quick_rejoin_attempts++;
+        zgDefaultChannelList = (uint32)1 << cand->channel;
+        _NIB.nwkLogicalChannel = cand->channel;
+        if (_NIB.nwkPanId == 0xFFFF && rejoin_cache_pan_id != 0xFFFF) {
+            _NIB.nwkPanId = rejoin_cache_pan_id;
+        }
+        LREP("Candidate rejoin on channel %d (best 0x%X lqi=%d depth=%d)\r\n", cand->channel, cand->short_addr, cand->lqi,
+             cand->depth);
+        return true;
+    }
 
-            // Note: Z-Stack handles channel setting internally
-            // Just attempt rejoin, it will use scan results
+    if (last_channel < 11 || last_channel > 26) {
+        // Not cached in RAM yet (e.g. right after boot) - fall back to the NV record
+        last_channel = nvState.last_channel;
+    }
 
-            return true;
+    if (last_channel >= 11 && last_channel <= 26 && quick_rejoin_attempts < APP_COMMISSIONING_QUICK_REJOIN_ATTEMPTS) {
+        quick_rejoin_attempts++;
+        zgDefaultChannelList = (uint32)1 << last_channel;
+        _NIB.nwkLogicalChannel = last_channel;
+        if (_NIB.nwkPanId == 0xFFFF && rejoin_cache_pan_id != 0xFFFF) {
+            _NIB.nwkPanId = rejoin_cache_pan_id;
+        }
+        if (_NIB.nwkCoordAddress == INVALID_NODE_ADDR && rejoin_cache_parent != INVALID_NODE_ADDR) {
+            _NIB.nwkCoordAddress = rejoin_cache_parent;
         }
+        LREP("Quick rejoin attempt %d on channel %d pan=0x%X parent=0x%X\r\n", quick_rejoin_attempts, last_channel,
+             _NIB.nwkPanId, _NIB.nwkCoordAddress);
+        return true;
     }
 
-    LREP("No valid last channel, will do full scan\r\n");
+    zgDefaultChannelList = DEFAULT_CHANLIST;
+    LREP("No valid last channel or quick attempts used, will do full scan\r\n");
     return false;
 }
 
+/*********************************************************************
+ * @fn      zclCommissioning_EndRejoinAttempt
+ * @brief   Record how long the rejoin attempt in flight took
+ * @param   restored - true if the attempt brought the network back
+ * @return  none
+ */
+static void zclCommissioning_EndRejoinAttempt(bool restored) {
+    if (rejoin_attempt_start == 0) {
+        return;
+    }
+    network_metrics.last_rejoin_time_ms = osal_GetSystemClock() - rejoin_attempt_start;
+    rejoin_attempt_start = 0;
+    if (!restored && rejoin_candidate != 0xFF) {
+        // Nothing took us on the candidate's channel - demote it so the next pick differs
+        nvState.candidates[rejoin_candidate].lqi >>= 1;
+    }
+    rejoin_candidate = 0xFF;
+    LREP("Rejoin attempt (%s scan) %s after %ld ms\r\n", (zgDefaultChannelList == DEFAULT_CHANLIST) ? "full" : "cached",
+         restored ? "restored" : "failed", network_metrics.last_rejoin_time_ms);
+}
+
 /*********************************************************************
  * @fn      zclCommissioning_CheckDeepSleep
  * @brief   Check if device should enter deep sleep mode
@@ -202,38 +687,86 @@ static void zclCommissioning_CheckDeepSleep(void) {
                    network_metrics.consecutive_failures);
         LREPMaster("Will retry every 1 hour to save battery\r\n");
 
-        // Use very long delay to save battery
-        rejoinDelay = APP_COMMISSIONING_DEEP_SLEEP_INTERVAL;
+        // Use very long delay to save battery, jittered so a site doesn't wake in lockstep
+        rejoinDelay = backoff_Spread(APP_COMMISSIONING_DEEP_SLEEP_INTERVAL, APP_COMMISSIONING_DEEP_SLEEP_SPREAD_SHIFT);
 
         // Brief 200ms flash — explicit off timer so LED doesn't stay on during 1hr sleep
         HalLedSet(HAL_LED_1, HAL_LED_MODE_ON);
-        osal_start_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT, 200);
+        wakeScheduler_Start(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT, 200, 0);
 
         LREP("Battery saver: 1-hour rejoin interval active\r\n");
     }
 }
 
+/*********************************************************************
+ * @fn      zclCommissioning_SelectEndDeviceTimeout
+ * @brief   Choose the smallest End Device Timeout that covers
+ *          APP_COMMISSIONING_END_DEVICE_TIMEOUT_POLLS long polls and
+ *          renegotiate with the parent if it changed (arbiter callback)
+ * @param   pollRate - effective long-poll interval, ms
+ * @return  none
+ */
+static void zclCommissioning_SelectEndDeviceTimeout(uint32 pollRate) {
+    uint32 needSeconds = (pollRate / 1000 + 1) * APP_COMMISSIONING_END_DEVICE_TIMEOUT_POLLS;
+    uint8 idx = 0; // 10 seconds; index n >= 1 is 2^n minutes
+    if (needSeconds > 10) {
+        idx = 1;
+        while (idx < 14 && ((uint32)60 << idx) < needSeconds) {
+            idx++;
+        }
+    }
+    if (idx == zgEndDeviceTimeoutValue) {
+        return;
+    }
+    LREP("End device timeout index %d -> %d (long poll %ld ms)\r\n", zgEndDeviceTimeoutValue, idx, pollRate);
+    zgEndDeviceTimeoutValue = idx;
+#if ZG_BUILD_ENDDEVICE_TYPE
+    if (devState == DEV_END_DEVICE) {
+        NLME_SendEndDevTimeoutReq(); // parent keeps us as long as we poll (MAC data poll keep-alive)
+    }
+#endif
+}
+
 void zclCommissioning_Init(uint8 task_id) {
     zclCommissioning_TaskId = task_id;
     led_breathing_init(task_id);
+    pollArbiter_Init(task_id);
+    // Set before the first join so the parent gets a timeout matched to our poll rate right away
+    zclCommissioning_SelectEndDeviceTimeout(pollArbiter_LongPollRate());
+    pollArbiter_RegisterLongPollCB(zclCommissioning_SelectEndDeviceTimeout);
+    backoff_Seed();
 
     bdb_RegisterCommissioningStatusCB(zclCommissioning_ProcessCommissioningStatus);
     bdb_RegisterBindNotificationCB(zclCommissioning_BindNotification);
+    bdb_RegisterForFilterNwkDescCB(zclCommissioning_FilterNwkDesc);
+
+    // Interview detection: the coordinator's ZDO discovery and bind requests
+    ZDO_RegisterForZDOMsg(task_id, Node_Desc_req);
+    ZDO_RegisterForZDOMsg(task_id, Active_EP_req);
+    ZDO_RegisterForZDOMsg(task_id, Simple_Desc_req);
+    ZDO_RegisterForZDOMsg(task_id, Bind_req);
+
+    // One NV access for all library state (metrics, backoff, channel, candidates)
+    bool fwChanged = nvState_Init();
+
+    // Firmware update: the old backoff/give-up streak belongs to the old image - start retries fresh.
+    // BDB network state is kept (the old stamp's bdb_resetLocalAction() caused a reboot loop).
+    if (fwChanged) {
+        nvState.backoff.rejoinDelay = 0;
+        nvState.metrics.consecutive_failures = 0;
+    }
 
-    // FW version stamp disabled — was causing infinite reboot loop on fresh flash
-    // TODO: investigate why bdb_resetLocalAction() prevents normal boot
-    // Original intent: detect firmware update, auto-clear stale BDB NV state
-
-    // Hybrid Phase 2: Load network metrics from NV
-    if (osal_nv_read(ZCD_NV_NETWORK_METRICS, 0, sizeof(NetworkMetrics_t), &network_metrics) == SUCCESS) {
+    // Hybrid Phase 2: Load network metrics from the NV record
+    osal_memcpy(&network_metrics, &nvState.metrics, sizeof(NetworkMetrics_t));
+    if (network_metrics.rejoin_attempts != 0 || network_metrics.rejoin_successes != 0) {
         LREP("Loaded network metrics: rejoins=%d successes=%d failures=%d\r\n",
              network_metrics.rejoin_attempts,
              network_metrics.rejoin_successes,
              network_metrics.rejoin_failures);
 
         // Restore saved TX power
-        if (network_metrics.current_tx_power >= 0 &&  // 0 = TX_PWR_0_DBM
-            network_metrics.current_tx_power <= 4) {  // 4 = TX_PWR_PLUS_4
+        if (network_metrics.current_tx_power >= APP_TX_POWER_MIN &&
+            network_metrics.current_tx_power <= APP_TX_POWER) {
             current_tx_power = network_metrics.current_tx_power;
         }
     } else {
@@ -241,10 +774,9 @@ void zclCommissioning_Init(uint8 task_id) {
     }
 
     // Issue #24: Load rejoin backoff state from NV to maintain exponential backoff across power cycles
-    RejoinBackoffState_t backoff_state;
-    if (osal_nv_read(ZCD_NV_REJOIN_BACKOFF_STATE, 0, sizeof(RejoinBackoffState_t), &backoff_state) == SUCCESS) {
-        rejoinsLeft = backoff_state.rejoinsLeft;
-        rejoinDelay = backoff_state.rejoinDelay;
+    if (nvState.backoff.rejoinDelay != 0) {
+        rejoinsLeft = nvState.backoff.rejoinsLeft;
+        rejoinDelay = nvState.backoff.rejoinDelay;
         LREP("Loaded rejoin backoff state: rejoinsLeft=%d rejoinDelay=%ld\r\n", rejoinsLeft, rejoinDelay);
     }
 
@@ -256,55 +788,141 @@ void zclCommissioning_Init(uint8 task_id) {
     // to make this work, coordinator should be compiled with this flag #define TP2_LEGACY_ZC
     requestNewTrustCenterLinkKey = FALSE;
 
-    bdb_StartCommissioning(BDB_COMMISSIONING_MODE_NWK_STEERING | BDB_COMMISSIONING_MODE_FINDING_BINDING);
+    zclCommissioning_StartSteering();
 }
 
 static void zclCommissioning_ResetBackoffRetry(void) {
     rejoinsLeft = APP_COMMISSIONING_END_DEVICE_REJOIN_TRIES;
     rejoinDelay = APP_COMMISSIONING_END_DEVICE_REJOIN_START_DELAY;
-    quick_rejoin_attempted = false; // Reset for next time
+    quick_rejoin_attempts = 0; // Reset for next time
+    zgDefaultChannelList = DEFAULT_CHANLIST;
 
     // Issue #24: Clear saved backoff state on successful connection
-    zclCommissioning_SaveBackoffState();
+    zclCommissioning_NvMarkDirty();
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_FlushQueue
+ * @brief   Send the readings queued while offline; if the stack refused
+ *          a frame, retry shortly while retries are left
+ * @param   none
+ * @return  none
+ */
+static void zclCommissioning_FlushQueue(void) {
+    reportQueue_Flush();
+    // Also covers a restore reported before devState reads DEV_END_DEVICE (Flush sends nothing then)
+    if (reportQueue_Count() == 0 || queue_retries_left == 0) {
+        return;
+    }
+    queue_retries_left--;
+    LREP("Report queue: %d readings left, retrying\r\n", reportQueue_Count());
+    wakeScheduler_Start(zclCommissioning_TaskId, APP_COMMISSIONING_QUEUE_RETRY_EVT, APP_COMMISSIONING_QUEUE_RETRY_DELAY,
+                        QUEUED_POLL_RATE);
 }
 
 static void zclCommissioning_OnConnect(void) {
     LREPMaster("[OK] zclCommissioning_OnConnect\r\n");
 
-    // Cancel any pending poll-rate changes from button presses
-    osal_stop_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_POLL_NORMAL_EVT);
-    osal_stop_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT);
+    // A join after a give-up or re-pair follows a parent loss too
+    pollArbiter_Resume();
+
+    // Cancel any pending poll-rate changes from pairing or button presses
+    pollArbiter_Release(POLL_CLIENT_PAIRING);
+    pollArbiter_Release(POLL_CLIENT_BUTTON);
+    wakeScheduler_Stop(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT);
 
     // Update metrics - successful connection!
     network_metrics.rejoin_successes++;
     network_metrics.consecutive_failures = 0; // Reset failure counter
     zclCommissioning_UpdateNetworkQuality();
 
-    // Reduce TX power for next time (save battery)
-    zclCommissioning_AdaptiveTxPower(false);
+    // Current parent is a proven candidate for the next loss
+    zclCommissioning_OnBeacon(_NIB.nwkCoordAddress, _NIB.extendedPANID, _NIB.nwkLogicalChannel, network_metrics.parent_lqi,
+                              (_NIB.nodeDepth > 0) ? (_NIB.nodeDepth - 1) : 0,
+                              PARENT_CANDIDATE_FLAG_ROUTER_CAPACITY | PARENT_CANDIDATE_FLAG_DEVICE_CAPACITY);
+    zclCommissioning_NvMarkDirty();
+
+    if (txpwr_fed) {
+        // The closed loop walks TX power down once the link proves strong
+        txpwr_window_frames = 0;
+        txpwr_window_failures = 0;
+        txpwr_trend = 0;
+    } else {
+        // Nothing feeds the loop yet: keep the open-loop step down after each join (save battery)
+        zclCommissioning_AdaptiveTxPower(false);
+    }
 
     zclCommissioning_ResetBackoffRetry();
 
+#if APP_COMMISSIONING_JOIN_PROFILE == APP_COMMISSIONING_JOIN_PROFILE_COORD_BIND
+    zclCommissioning_BindCoordinator();
+#endif
+
+    // Readings taken while offline go out now, while the radio is awake for the interview anyway
+    queue_retries_left = APP_COMMISSIONING_QUEUE_RETRIES;
+    zclCommissioning_FlushQueue();
+    // Rejoin counters just moved - a bound dashboard sees them now (no binding yet on a first join)
+    zclDiagnostics_Update();
+
     // Join-success LED pattern: 3 quick flashes (100ms ON/OFF × 3)
     // Uses OSAL timer state machine — never HalLedBlink (SED-safe)
     led_breathing_stop();
-    join_flash_counter = 6;  // 3 ON + 3 OFF transitions
+    // 3 ON + 3 OFF transitions; a single flash once the battery is low
+    join_flash_counter = (zclPowerProfile_Current == POWER_PROFILE_NORMAL) ? 6 : 2;
     HalLedSet(HAL_LED_1, HAL_LED_MODE_ON);  // First flash ON
     osal_start_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_JOIN_FLASH_EVT, 100);
 
+    // Stay awake while the coordinator completes interview/configuration
+    // (endpoint discovery, attribute reads, binding, reporting configuration).
+    // Each interview request pushes the end out by the quiet period, up to the hard cap;
+    // then poll rate reverts to normal via CLOCK_DOWN_POLING_RATE_EVT
+    uint32 interviewPeriod = zclPowerProfile_CapInterview(APP_COMMISSIONING_INTERVIEW_PERIOD);
+    interview_start = osal_GetSystemClock();
+    interview_last = 0;
+    interview_request = 0;
+    interview_deadline = interview_start + interviewPeriod;
+
     // Fast poll during interview so coordinator can configure reporting/bindings quickly
-#if defined(POWER_SAVING)
     zclCommissioning_interviewActive = true;
-    NLME_SetPollRate(QUEUED_POLL_RATE);
-    LREP("Fast poll (%dms) for interview\r\n", QUEUED_POLL_RATE);
-#endif
+    pollArbiter_Request(POLL_CLIENT_INTERVIEW, QUEUED_POLL_RATE, POLL_PRIORITY_NORMAL, interviewPeriod);
+    LREP("Fast poll (%dms) for interview, at most %d seconds\r\n", QUEUED_POLL_RATE, (int)(interviewPeriod / 1000));
+    wakeScheduler_Start(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT,
+                        MIN(APP_COMMISSIONING_INTERVIEW_START_GRACE, interviewPeriod), QUEUED_POLL_RATE);
+}
+
+// Push the end of the interview window out by the quiet period, up to the hard cap
+static void zclCommissioning_ExtendInterview(void) {
+    interview_last = osal_GetSystemClock();
+    int32 left = (int32)(interview_deadline - interview_last);
+    if (left <= 0) {
+        return; // hard cap reached, CLOCK_DOWN is already due
+    }
+    // Any fast poll up to one period later may end the window
+    wakeScheduler_Start(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT,
+                        MIN(APP_COMMISSIONING_INTERVIEW_QUIET, (uint32)left), QUEUED_POLL_RATE);
+}
 
-    // Stay awake for 60 seconds to allow coordinator to complete interview/configuration
-    // (endpoint discovery, attribute reads, binding, reporting configuration)
-    // Z2M typically completes in 30-60s, ZHA in 30-90s.
-    // After this period, poll rate reverts to normal via CLOCK_DOWN_POLING_RATE_EVT
-    LREP("Staying awake for %d seconds for coordinator interview\r\n", APP_COMMISSIONING_INTERVIEW_PERIOD / 1000);
-    osal_start_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT, APP_COMMISSIONING_INTERVIEW_PERIOD);
+void zclCommissioning_OnInterviewActivity(void) {
+    if (!zclCommissioning_interviewActive) {
+        return;
+    }
+    zclCommissioning_ExtendInterview();
+    interview_request = interview_last;
+}
+
+/*********************************************************************
+ * @fn      zclCommissioning_EndInterview
+ * @brief   Close the fast-poll window and record how long the interview
+ *          actually took (join to last request)
+ * @param   none
+ * @return  none
+ */
+static void zclCommissioning_EndInterview(void) {
+    zclCommissioning_interviewActive = false;
+    network_metrics.last_interview_ms = interview_last ? (interview_last - interview_start) : 0;
+    LREP("Interview done: %ld ms of traffic, fast poll for %ld ms\r\n", network_metrics.last_interview_ms,
+         osal_GetSystemClock() - interview_start);
+    zclCommissioning_NvMarkDirty();
 }
 
 static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_t *bdbCommissioningModeMsg) {
@@ -331,8 +949,9 @@ static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_
         switch (bdbCommissioningModeMsg->bdbCommissioningStatus) {
         case BDB_COMMISSIONING_SUCCESS:
             if (pairing_mode_active) {
-                osal_stop_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_PAIRING_TIMEOUT_EVT);
-                osal_stop_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_END_DEVICE_REJOIN_EVT);
+                wakeScheduler_Stop(zclCommissioning_TaskId, APP_COMMISSIONING_PAIRING_TIMEOUT_EVT);
+                wakeScheduler_Stop(zclCommissioning_TaskId, APP_COMMISSIONING_END_DEVICE_REJOIN_EVT);
+                pollArbiter_Release(POLL_CLIENT_PAIRING);
                 pairing_mode_active = false;
             }
             // Success: stop blink, solid ON — ZDO_STATE_CHANGE → DEV_END_DEVICE will turn off
@@ -347,9 +966,9 @@ static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_
                 // Still in pairing window — schedule retry, keep LED blinking
                 LREP("Join failed - retrying in %d seconds\r\n",
                      (int)(APP_COMMISSIONING_JOIN_RETRY_INTERVAL / 1000));
-                osal_start_timerEx(zclCommissioning_TaskId,
-                                   APP_COMMISSIONING_END_DEVICE_REJOIN_EVT,
-                                   APP_COMMISSIONING_JOIN_RETRY_INTERVAL);
+                wakeScheduler_Start(zclCommissioning_TaskId, APP_COMMISSIONING_END_DEVICE_REJOIN_EVT,
+                                    APP_COMMISSIONING_JOIN_RETRY_INTERVAL,
+                                    APP_COMMISSIONING_JOIN_RETRY_INTERVAL >> APP_COMMISSIONING_REJOIN_TOLERANCE_SHIFT);
             } else {
                 LREP("Network join failed - press button to retry\r\n");
             }
@@ -363,14 +982,57 @@ static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_
         switch (bdbCommissioningModeMsg->bdbCommissioningStatus) {
         case BDB_COMMISSIONING_NETWORK_RESTORED:
             LREPMaster("[OK] Network restored successfully!\r\n");
+            // The stack restored its own poll rate - put the arbiter's winner back
+            pollArbiter_Resume();
+            zclCommissioning_EndRejoinAttempt(true);
+            if (parent_switch_from != INVALID_NODE_ADDR) {
+                // The stack picks the parent from the beacons it hears - often the same weak one
+                if (_NIB.nwkCoordAddress != parent_switch_from) {
+                    LREP("Parent switch done: 0x%X -> 0x%X\r\n", parent_switch_from, _NIB.nwkCoordAddress);
+                    network_metrics.parent_switches++;
+                    parent_switch_misses = 0;
+                } else {
+                    LREP("Parent switch failed: back on 0x%X\r\n", parent_switch_from);
+                    if (parent_switch_misses < APP_COMMISSIONING_PARENT_SWITCH_MAX_BACKOFF) {
+                        parent_switch_misses++;
+                    }
+                }
+                parent_switch_from = INVALID_NODE_ADDR;
+            }
+            link_lqi_ewma = 0;
+            link_weak_samples = 0;
             zclCommissioning_ResetBackoffRetry();
             network_metrics.consecutive_failures = 0;
+            // OnConnect doesn't run for a rejoin - send what was queued while orphaned here
+            queue_retries_left = APP_COMMISSIONING_QUEUE_RETRIES;
+            zclCommissioning_FlushQueue();
+            // Rejoin counters, parent and channel just moved
+            network_metrics.rejoin_successes++;
+            zclCommissioning_UpdateNetworkQuality();
+            zclDiagnostics_Update();
             break;
 
         default:
+            pollArbiter_Suspend(); // orphaned - the stack isn't polling at our rate any more
+            if (parent_switch_state == PARENT_SWITCH_STARTED) {
+                // Self-inflicted loss from a proactive switch: rejoin right away, not a failure
+                parent_switch_state = PARENT_SWITCH_IDLE;
+                link_weak_samples = 0;
+                osal_set_event(zclCommissioning_TaskId, APP_COMMISSIONING_END_DEVICE_REJOIN_EVT);
+                break;
+            }
+            if (parent_switch_state == PARENT_SWITCH_SCHEDULED) {
+                // Lost the parent before our switch ran - a genuine loss, drop the switch
+                osal_stop_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_PARENT_SWITCH_EVT);
+                parent_switch_state = PARENT_SWITCH_IDLE;
+                link_weak_samples = 0;
+            }
+
             // Removed LED blink on rejoin failure - can be very frequent if network unstable
             // LED will blink on final failure (give-up) or deep sleep mode instead
 
+            zclCommissioning_EndRejoinAttempt(false);
+
             // Update failure metrics
             network_metrics.rejoin_attempts++;
             network_metrics.rejoin_failures++;
@@ -385,16 +1047,19 @@ static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_
             // Increase TX power for next attempt (if not already at max)
             zclCommissioning_AdaptiveTxPower(true);
 
-            // Exponential backoff
+            // Jittered integer exponential backoff (seeded from IEEE - devices don't retry in lockstep)
             if (rejoinsLeft > 0) {
-                rejoinDelay *= APP_COMMISSIONING_END_DEVICE_REJOIN_BACKOFF;
+                rejoinDelay = backoff_Next(APP_COMMISSIONING_END_DEVICE_REJOIN_JITTER,
+                                           APP_COMMISSIONING_END_DEVICE_REJOIN_START_DELAY, rejoinDelay,
+                                           APP_COMMISSIONING_END_DEVICE_REJOIN_TRIES - rejoinsLeft,
+                                           APP_COMMISSIONING_END_DEVICE_REJOIN_MAX_DELAY);
                 rejoinsLeft -= 1;
             } else {
-                rejoinDelay = APP_COMMISSIONING_END_DEVICE_REJOIN_MAX_DELAY;
+                rejoinDelay = backoff_Spread(APP_COMMISSIONING_END_DEVICE_REJOIN_MAX_DELAY, APP_COMMISSIONING_DEEP_SLEEP_SPREAD_SHIFT);
             }
 
-            // Issue #24: Save updated backoff state to persist across power cycles
-            zclCommissioning_SaveBackoffState();
+            // Issue #24: Backoff state persists across power cycles (coalesced, bounded staleness)
+            zclCommissioning_NvMarkDirty();
 
             // Check if should enter deep sleep mode
             zclCommissioning_CheckDeepSleep();
@@ -407,7 +1072,7 @@ static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_
                 LREPMaster("Press button to manually retry joining\r\n");
 
                 // Issue #25: Persist give-up state to NV so device remembers after power cycle
-                osal_nv_write(ZCD_NV_NETWORK_METRICS, 0, sizeof(NetworkMetrics_t), &network_metrics);
+                zclCommissioning_NvFlush();
 
                 led_breathing_stop();
 
@@ -415,13 +1080,9 @@ static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_
                 break;
             }
 
-            // Try quick rejoin first (on first attempt)
-            if (!quick_rejoin_attempted && network_metrics.last_channel != 0) {
-                quick_rejoin_attempted = true;
-                zclCommissioning_QuickRejoin();
-            }
-
-            osal_start_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_END_DEVICE_REJOIN_EVT, rejoinDelay);
+            // The delay is jittered anyway - a little more to share a wakeup costs nothing
+            wakeScheduler_Start(zclCommissioning_TaskId, APP_COMMISSIONING_END_DEVICE_REJOIN_EVT, rejoinDelay,
+                                rejoinDelay >> APP_COMMISSIONING_REJOIN_TOLERANCE_SHIFT);
             break;
         }
         break;
@@ -431,6 +1092,8 @@ static void zclCommissioning_ProcessCommissioningStatus(bdbCommissioningModeMsg_
 }
 
 static void zclCommissioning_ProcessIncomingMsg(zclIncomingMsg_t *pInMsg) {
+    // Foundation commands ZCL passes up (configure reporting, writes, discovery) are interview traffic
+    zclCommissioning_OnInterviewActivity();
     if (pInMsg->attrCmd) {
         osal_mem_free(pInMsg->attrCmd);
     }
@@ -438,14 +1101,20 @@ static void zclCommissioning_ProcessIncomingMsg(zclIncomingMsg_t *pInMsg) {
 
 void zclCommissioning_Sleep(uint8 allow) {
     LREP("zclCommissioning_Sleep %d\r\n", allow);
+    if (allow) {
+        // Idle window: radio traffic is done, batch the deferred NV writes here
+        zclCommissioning_NvFlush();
+    }
+    // Drop the short-lived fast-poll requests; the arbiter falls back to the slowest permitted rate
+    pollArbiter_Release(POLL_CLIENT_BUTTON);
+    if (allow) {
+        pollArbiter_Release(POLL_CLIENT_INTERVIEW);
+    }
 #if defined(POWER_SAVING)
     if (allow) {
-        NLME_SetPollRate(POLL_RATE);
         led_breathing_stop();
         HalLedSet(HAL_LED_1, HAL_LED_MODE_OFF);
         LREP("Sleep mode - LED off\r\n");
-    } else {
-        NLME_SetPollRate(POLL_RATE);
     }
 #endif
 }
@@ -475,6 +1144,17 @@ uint16 zclCommissioning_event_loop(uint8 task_id, uint16 events) {
                 zclCommissioning_ProcessIncomingMsg((zclIncomingMsg_t *)MSGpkt);
                 break;
 
+            case AF_DATA_CONFIRM_CMD:
+                // Forwarded by ZCL when this task is its message task (zcl_registerForMsg)
+                // Also extends the interview for replies to the coordinator's requests
+                zclCommissioning_OnTxConfirm(((afDataConfirm_t *)MSGpkt)->hdr.status);
+                break;
+
+            case ZDO_CB_MSG:
+                // Descriptor/bind requests registered in Init - the stack still answers them
+                zclCommissioning_OnInterviewActivity();
+                break;
+
             default:
                 break;
             }
@@ -492,9 +1172,11 @@ uint16 zclCommissioning_event_loop(uint8 task_id, uint16 events) {
         if (pairing_mode_active) {
             // Initial join retry — try fresh commissioning
             LREP("Pairing retry attempt\r\n");
-            bdb_StartCommissioning(BDB_COMMISSIONING_MODE_NWK_STEERING | BDB_COMMISSIONING_MODE_FINDING_BINDING);
+            zclCommissioning_StartSteering();
         } else {
-            // Parent lost rejoin — recover existing network
+            // Parent lost rejoin — recover existing network, cached channel first
+            zclCommissioning_QuickRejoin();
+            rejoin_attempt_start = osal_GetSystemClock();
             bdb_ZedAttemptRecoverNwk();
         }
 #endif
@@ -503,15 +1185,30 @@ uint16 zclCommissioning_event_loop(uint8 task_id, uint16 events) {
 
     if (events & APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT) {
         LREPMaster("APP_CLOCK_DOWN_POLING_RATE_EVT\r\n");
-        zclCommissioning_interviewActive = false;
+        if (zclCommissioning_interviewActive) {
+            zclCommissioning_EndInterview();
+        }
         zclCommissioning_Sleep(true);
         return (events ^ APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT);
     }
 
-    if (events & APP_COMMISSIONING_POLL_NORMAL_EVT) {
-        LREPMaster("APP_POLL_NORMAL_EVT\r\n");
-        zclCommissioning_Sleep(false);
-        return (events ^ APP_COMMISSIONING_POLL_NORMAL_EVT);
+    if (events & APP_COMMISSIONING_PARENT_SWITCH_EVT) {
+        zclCommissioning_StartParentSwitch();
+        return (events ^ APP_COMMISSIONING_PARENT_SWITCH_EVT);
+    }
+
+    if (events & APP_COMMISSIONING_QUEUE_RETRY_EVT) {
+        zclCommissioning_FlushQueue();
+        return (events ^ APP_COMMISSIONING_QUEUE_RETRY_EVT);
+    }
+
+    if (events & APP_COMMISSIONING_NV_FLUSH_EVT) {
+        zclCommissioning_NvFlush();
+        return (events ^ APP_COMMISSIONING_NV_FLUSH_EVT);
+    }
+
+    if (events & POLL_ARBITER_EVT) {
+        return pollArbiter_event_loop(task_id, events);
     }
 
     if (events & LED_BREATHING_EVT) {
@@ -536,11 +1233,9 @@ uint16 zclCommissioning_event_loop(uint8 task_id, uint16 events) {
     if (events & APP_COMMISSIONING_PAIRING_TIMEOUT_EVT) {
         if (pairing_mode_active) {
             pairing_mode_active = false;
-            osal_stop_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_END_DEVICE_REJOIN_EVT);
+            wakeScheduler_Stop(zclCommissioning_TaskId, APP_COMMISSIONING_END_DEVICE_REJOIN_EVT);
             led_breathing_stop();
-#if defined(POWER_SAVING)
-            NLME_SetPollRate(POLL_RATE);
-#endif
+            pollArbiter_Release(POLL_CLIENT_PAIRING);
             LREPMaster("Pairing timeout: LED off, normal poll rate\r\n");
         }
         return (events ^ APP_COMMISSIONING_PAIRING_TIMEOUT_EVT);
@@ -582,20 +1277,16 @@ void zclCommissioning_HandleKeys(uint8 portAndAction, uint8 keyCode) {
                 // This restarts the 5-minute pairing window with LED breathing
                 LREP("devState=%d starting pairing mode\r\n", devState);
                 zclCommissioning_StartPairingMode();
-                bdb_StartCommissioning(BDB_COMMISSIONING_MODE_NWK_STEERING | BDB_COMMISSIONING_MODE_FINDING_BINDING);
+                zclCommissioning_StartSteering();
                 pairingStarted = true;  // StartPairingMode handles poll rate
             }
         }
 #endif
 
-        #if defined(POWER_SAVING)
-            // Fast poll for button responsiveness (skip if pairing mode
-            // already set fast poll — the 3s revert would kill it)
-            if (!pairingStarted) {
-                NLME_SetPollRate(QUEUED_POLL_RATE);
-                // Revert to normal poll rate after 3 seconds
-                osal_start_timerEx(zclCommissioning_TaskId, APP_COMMISSIONING_POLL_NORMAL_EVT, 3000);
-            }
-        #endif
+        // Fast poll for button responsiveness for 3 seconds; pairing holds its own,
+        // higher-priority request so this can no longer cut the pairing window short
+        if (!pairingStarted) {
+            pollArbiter_Request(POLL_CLIENT_BUTTON, QUEUED_POLL_RATE, POLL_PRIORITY_NORMAL, 3000);
+        }
     }
 }
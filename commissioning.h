@@ -4,38 +4,136 @@
 #define APP_COMMISSIONING_CLOCK_DOWN_POLING_RATE_EVT  0x0001
 #define APP_COMMISSIONING_END_DEVICE_REJOIN_EVT       0x0002
 #define APP_COMMISSIONING_PAIRING_TIMEOUT_EVT         0x0004
-#define APP_COMMISSIONING_POLL_NORMAL_EVT             0x0008
+#define APP_COMMISSIONING_QUEUE_RETRY_EVT             0x0008  // resend offline readings the stack refused
 #define APP_COMMISSIONING_JOIN_FLASH_EVT              0x0010  // 3-flash join success pattern
+#define APP_COMMISSIONING_PARENT_SWITCH_EVT           0x0040  // proactive parent switch in an idle window
+#define APP_COMMISSIONING_NV_FLUSH_EVT                0x0080  // staleness bound for deferred NV writes
+// 0x0020 is LED_BREATHING_EVT, 0x0100 POLL_ARBITER_EVT - both run on this task
 
 // Enhanced rejoin strategy (Hybrid Phase 2)
 #define APP_COMMISSIONING_END_DEVICE_REJOIN_MAX_DELAY ((uint32)900000) // 15 minutes (reduced from 30 for battery)
 #define APP_COMMISSIONING_END_DEVICE_REJOIN_START_DELAY 10 * 1000 // 10 seconds
-#define APP_COMMISSIONING_END_DEVICE_REJOIN_BACKOFF ((float) 1.5) // More aggressive (was 1.2)
+// Growth factor is BACKOFF_FACTOR_NUM / BACKOFF_FACTOR_DEN (1.5, integer) - see backoff.h
+#ifndef APP_COMMISSIONING_END_DEVICE_REJOIN_JITTER
+    #define APP_COMMISSIONING_END_DEVICE_REJOIN_JITTER BACKOFF_JITTER_DECORRELATED
+#endif
 #define APP_COMMISSIONING_END_DEVICE_REJOIN_TRIES 30 // Increased from 20
+// A rejoin may start up to delay >> SHIFT late to share a wakeup with another timer
+#ifndef APP_COMMISSIONING_REJOIN_TOLERANCE_SHIFT
+    #define APP_COMMISSIONING_REJOIN_TOLERANCE_SHIFT 4
+#endif
 
 // Interview/configuration period after successful join
-// Phase 1: QUEUED_POLL_RATE (100ms) for 60s — covers Z2M/ZHA interview
+// Phase 1: QUEUED_POLL_RATE (100ms) until the coordinator goes quiet — Z2M ~15s, ZHA up to ~90s
 // Phase 2: POLL_RATE (60s) — normal operation
-#define APP_COMMISSIONING_INTERVIEW_PERIOD ((uint32)60000) // 60 seconds for coordinator interview
+#ifndef APP_COMMISSIONING_INTERVIEW_PERIOD
+    #define APP_COMMISSIONING_INTERVIEW_PERIOD ((uint32)120000) // hard cap on the fast-poll window
+#endif
+#ifndef APP_COMMISSIONING_INTERVIEW_START_GRACE
+    #define APP_COMMISSIONING_INTERVIEW_START_GRACE ((uint32)15000) // wait this long for the first request
+#endif
+#ifndef APP_COMMISSIONING_INTERVIEW_QUIET
+    // Interview done after this long without requests - covers reads ZCL answers on its own,
+    // which are only seen through the confirms of our replies
+    #define APP_COMMISSIONING_INTERVIEW_QUIET ((uint32)30000)
+#endif
+#ifndef APP_COMMISSIONING_INTERVIEW_REPLY_WINDOW
+    // A TX confirm this soon after a coordinator request is taken as our reply (e.g. to a read
+    // ZCL answered itself) and extends the window; our own reports and telemetry don't
+    #define APP_COMMISSIONING_INTERVIEW_REPLY_WINDOW ((uint32)2000)
+#endif
 #define APP_COMMISSIONING_PAIRING_TIMEOUT ((uint32)300000)  // 5 minutes max fast-blink pairing window
 
+// Offline readings (report_queue.h) go out after every join or rejoin; frames the stack refused
+// are retried this often, this many times - inside the post-join fast-poll window
+#ifndef APP_COMMISSIONING_QUEUE_RETRY_DELAY
+    #define APP_COMMISSIONING_QUEUE_RETRY_DELAY ((uint32)5000)
+#endif
+#ifndef APP_COMMISSIONING_QUEUE_RETRIES
+    #define APP_COMMISSIONING_QUEUE_RETRIES 3
+#endif
+
+// Tiered steering: BDB scans the primary set (preferred channels + last known channel) first
+// and only then the rest of DEFAULT_CHANLIST. Default: 11, 15, 20, 25
+#ifndef APP_COMMISSIONING_PREFERRED_CHANNELS
+    #define APP_COMMISSIONING_PREFERRED_CHANNELS ((uint32)0x02108800)
+#endif
+// Join profile: what runs after steering
+#define APP_COMMISSIONING_JOIN_PROFILE_FULL       0 // steering + Finding & Binding (BDB default)
+#define APP_COMMISSIONING_JOIN_PROFILE_STEERING   1 // steering only - coordinator configures bindings itself
+#define APP_COMMISSIONING_JOIN_PROFILE_COORD_BIND 2 // steering, then bind the clusters below straight to the coordinator
+#ifndef APP_COMMISSIONING_JOIN_PROFILE
+    #define APP_COMMISSIONING_JOIN_PROFILE APP_COMMISSIONING_JOIN_PROFILE_FULL
+#endif
+#ifndef APP_COMMISSIONING_COORD_BIND_CLUSTERS
+    #define APP_COMMISSIONING_COORD_BIND_CLUSTERS ZCL_CLUSTER_ID_GEN_POWER_CFG
+#endif
+#ifndef APP_COMMISSIONING_COORD_BIND_SRC_ENDPOINT
+    #define APP_COMMISSIONING_COORD_BIND_SRC_ENDPOINT 1
+#endif
+#ifndef APP_COMMISSIONING_COORD_BIND_DST_ENDPOINT
+    #define APP_COMMISSIONING_COORD_BIND_DST_ENDPOINT 1
+#endif
+
+// Optional allow-list of extended PAN IDs (8 bytes each, little-endian as sent over the air);
+// networks not on it are dropped from steering. e.g.
+// #define APP_COMMISSIONING_EXT_PAN_ALLOW_LIST {0xDD, 0xDD, 0xDD, 0xDD, 0xDD, 0xDD, 0xDD, 0xDD}
+
 // Deep sleep mode after many failures
 #define APP_COMMISSIONING_DEEP_SLEEP_THRESHOLD 50 // After 50 consecutive failures
 #define APP_COMMISSIONING_DEEP_SLEEP_INTERVAL ((uint32)3600000) // 1 hour between retries
+#define APP_COMMISSIONING_DEEP_SLEEP_SPREAD_SHIFT 3 // jitter deep-sleep retries over the last 1/8 of the interval
 
 // Give up threshold - assume network is gone (coordinator reset, etc.)
 #define APP_COMMISSIONING_GIVE_UP_THRESHOLD 150 // After 150 consecutive failures (~6 days at 1hr intervals)
 // After this, device stops retrying and waits for button press
 
-// NV storage IDs for network metrics
+// Proactive parent switching: rejoin before the parent is lost outright
+#define APP_COMMISSIONING_PARENT_SWITCH_LQI 60 // smoothed LQI below this counts as a weak link
+#define APP_COMMISSIONING_PARENT_SWITCH_SAMPLES 8 // consecutive weak samples before switching
+#define APP_COMMISSIONING_PARENT_SWITCH_MIN_INTERVAL ((uint32)1800000) // 30 minutes between switches
+// A switch that rejoins the same parent doubles the interval, up to 2^this times
+#define APP_COMMISSIONING_PARENT_SWITCH_MAX_BACKOFF 3
+#define APP_COMMISSIONING_PARENT_SWITCH_IDLE_DELAY 2000 // let the current exchange finish first
+
+// Reasons recorded in NetworkMetrics_t.last_switch_reason
+#define PARENT_SWITCH_REASON_NONE 0
+#define PARENT_SWITCH_REASON_LOW_LQI 1
+#define PARENT_SWITCH_REASON_POLL_FAILURES 2
+#define PARENT_SWITCH_REASON_NO_MAC_ACK 3 // parent didn't MAC-ACK a frame after all retries
+#define PARENT_SWITCH_REASON_NO_APS_ACK 4 // link probe: no end-to-end ACK APP_COMMISSIONING_PROBE_FAILURES times
+
+// ACKED sends (link probes included, report_frame.h) failing in a row before a rejoin check
+#ifndef APP_COMMISSIONING_PROBE_FAILURES
+    #define APP_COMMISSIONING_PROBE_FAILURES 3
+#endif
+
+// End-device timeout: pick the smallest parent timeout (10s, 2min, 4min ... 16384min) that
+// still covers this many long-poll intervals, so a few lost polls never age us out
+#ifndef APP_COMMISSIONING_END_DEVICE_TIMEOUT_POLLS
+    #define APP_COMMISSIONING_END_DEVICE_TIMEOUT_POLLS 4
+#endif
+
+// NV write-back: dirty state is flushed at the next idle window, on give-up/reset,
+// or at the latest this long after it first became dirty
+#ifndef APP_COMMISSIONING_NV_MAX_STALENESS
+    #define APP_COMMISSIONING_NV_MAX_STALENESS ((uint32)600000) // 10 minutes
+#endif
+
+// Legacy NV storage IDs - migrated once into the single ZCD_NV_LIB_STATE record (nv_state.h)
 #define ZCD_NV_NETWORK_METRICS 0x0403
 #define ZCD_NV_LAST_CHANNEL 0x0404
 #define ZCD_NV_REJOIN_BACKOFF_STATE 0x0407
-#define ZCD_NV_FW_VERSION_STAMP 0x0408  // Detect firmware update → auto-clear stale NV
-#define FW_VERSION_STAMP_LEN 17         // ZCL string: 1 length byte + 16 chars "DD/MM/YYYY HH:MM"
+#define ZCD_NV_FW_VERSION_STAMP 0x0408  // superseded by the record's build hash
 
 // Note: TX_PWR_0_DBM through TX_PWR_PLUS_4 are defined in Z-Stack's ZMAC.h
 
+// Issue #24: Persist rejoin backoff state across power cycles
+typedef struct {
+    byte rejoinsLeft;
+    uint32 rejoinDelay;
+} RejoinBackoffState_t;
+
 // Hybrid Phase 2: Network Quality Metrics structure
 typedef struct {
     uint8 parent_lqi;            // Link Quality Indicator (0-255)
@@ -46,8 +144,27 @@ typedef struct {
     uint8 last_channel;          // Last successful channel (11-26)
     int8 current_tx_power;       // Current TX power in dBm (signed for PA devices)
     uint16 consecutive_failures; // Consecutive rejoin failures
+    uint16 parent_switches;      // Proactive parent switches that reached another parent
+    uint8 last_switch_reason;    // PARENT_SWITCH_REASON_*
+    uint32 last_interview_ms;    // Join to last interview request seen (0 = none observed)
+    uint16 aps_ack_failures;     // Frames the parent took but no APS ACK came back (link probe included)
 } NetworkMetrics_t;
 
+// Candidate parents heard in beacons. On parent loss the best one's channel is scanned first,
+// before any wide scan; the stack then picks the parent from that channel's beacons.
+#define APP_COMMISSIONING_PARENT_CANDIDATES 4
+#define PARENT_CANDIDATE_FLAG_ROUTER_CAPACITY 0x01
+#define PARENT_CANDIDATE_FLAG_DEVICE_CAPACITY 0x02
+
+typedef struct {
+    uint16 short_addr;         // INVALID_NODE_ADDR = empty slot
+    uint8 ext_pan_id[8];
+    uint8 channel;
+    uint8 lqi;
+    uint8 depth;
+    uint8 flags;               // PARENT_CANDIDATE_FLAG_*
+} ParentCandidate_t;
+
 // Global network metrics (accessible for ZCL reporting)
 extern NetworkMetrics_t network_metrics;
 
@@ -61,5 +178,27 @@ extern void zclCommissioning_Sleep( uint8 allow );
 extern void zclCommissioning_HandleKeys(uint8 portAndAction, uint8 keyCode);
 extern void zclCommissioning_StartPairingMode(void); // Aqara-style pairing LED
 extern void zclCommissioning_ResetState(void);       // Clear backoff/metrics for fresh join
+extern void zclCommissioning_NvFlush(void);          // Write out deferred NV state now (e.g. before a reset)
+// Closed-loop TX power inputs (auto mode). Until either one is fed, TX power steps down once per join.
+// LQI of every frame received from the parent: call from the app's ZCL plugin with
+// pInMsg->msg->LinkQuality (zclIncomingMsg_t carries no LQI, so the library can't see it)
+extern void zclCommissioning_OnLinkSample(uint8 lqi);
+// Status of every AF_DATA_CONFIRM_CMD. MAC no-ACK / CCA failures count against the link, and a
+// MAC no-ACK also weighs on the parent-switch estimate. A missing APS ACK (e.g. on the periodic
+// link probe) is end-to-end: it counts in aps_ack_failures, brings the next probe forward and,
+// APP_COMMISSIONING_PROBE_FAILURES times in a row, triggers a rejoin check.
+// Fed automatically when this task is the ZCL message task; otherwise forward the confirm's hdr.status.
+extern void zclCommissioning_OnTxConfirm(uint8 status);
+// Interview request from the coordinator. ZDO descriptor/bind requests are picked up automatically,
+// and so are ZCL foundation commands when this task is the ZCL message task. Otherwise call it from
+// the app's ZCL_INCOMING_MSG handling. Don't call it for confirms - zclCommissioning_OnTxConfirm
+// extends the window for replies within APP_COMMISSIONING_INTERVIEW_REPLY_WINDOW of a request.
+extern void zclCommissioning_OnInterviewActivity(void);
+// Status of every data poll - failures weigh on the link estimate, returned data keeps the poll
+// arbiter draining the parent's queue. The stack only reports it to ZDO_PollConfirmCB() in
+// ZDApp.c (an empty hook): add a call there, otherwise burst drain and poll-confirm link samples stay off.
+extern void zclCommissioning_OnPollConfirm(uint8 status);
+// Router heard in a beacon (e.g. from ZDO_beaconNotifyIndCB); steering discoveries are fed automatically
+extern void zclCommissioning_OnBeacon(uint16 shortAddr, uint8 *extPanId, uint8 channel, uint8 lqi, uint8 depth, uint8 flags);
 
 #endif
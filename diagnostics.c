@@ -0,0 +1,104 @@
+/*********************************************************************
+ * Network diagnostics cluster
+ *
+ * NetworkMetrics_t used to reach only the debug UART. It is now readable
+ * through the Diagnostics cluster (standard attributes) and a manufacturer
+ * cluster (the counters), and reported to the bound destinations
+ * whenever a value moves past its reportable change - parent LQI by
+ * ZCL_DIAGNOSTICS_LQI_CHANGE, the counters, channel, TX power and parent
+ * on any change - rate-limited by the min interval, with a heartbeat at
+ * the max interval. A fleet dashboard can then spot badly placed or
+ * struggling devices without a UART attached.
+ *********************************************************************/
+
+#include "diagnostics.h"
+#include "power_profile.h"
+#include "Debug.h"
+#include "OSAL.h"
+#include "ZDApp.h"
+#include "nwk_globals.h"
+
+uint16 zclDiagnostics_ParentAddr = 0xFFFF;
+
+// Attribute bindings for the reports - same order as ZCL_DIAGNOSTICS_ATTR_RECORDS / ZCL_DIAGNOSTICS_MS_ATTR_RECORDS
+static const zclReport_t zclDiagnostics_ReportBindings[ZCL_DIAGNOSTICS_NUM_ATTRS] = {
+    {ATTRID_DIAGNOSTICS_LAST_MESSAGE_LQI, ZCL_DATATYPE_UINT8, (void *)(&network_metrics.parent_lqi)},
+};
+
+static const zclReport_t zclDiagnostics_MsReportBindings[ZCL_DIAGNOSTICS_MS_NUM_ATTRS] = {
+    {ATTRID_DIAGNOSTICS_REJOIN_ATTEMPTS, ZCL_DATATYPE_UINT16, (void *)(&network_metrics.rejoin_attempts)},
+    {ATTRID_DIAGNOSTICS_REJOIN_SUCCESSES, ZCL_DATATYPE_UINT16, (void *)(&network_metrics.rejoin_successes)},
+    {ATTRID_DIAGNOSTICS_REJOIN_FAILURES, ZCL_DATATYPE_UINT16, (void *)(&network_metrics.rejoin_failures)},
+    {ATTRID_DIAGNOSTICS_CONSECUTIVE_FAILURES, ZCL_DATATYPE_UINT16, (void *)(&network_metrics.consecutive_failures)},
+    {ATTRID_DIAGNOSTICS_TX_POWER, ZCL_DATATYPE_INT8, (void *)(&network_metrics.current_tx_power)},
+    {ATTRID_DIAGNOSTICS_CHANNEL, ZCL_DATATYPE_UINT8, (void *)(&network_metrics.last_channel)},
+    {ATTRID_DIAGNOSTICS_PARENT_SWITCHES, ZCL_DATATYPE_UINT16, (void *)(&network_metrics.parent_switches)},
+    {ATTRID_DIAGNOSTICS_LAST_SWITCH_REASON, ZCL_DATATYPE_ENUM8, (void *)(&network_metrics.last_switch_reason)},
+    {ATTRID_DIAGNOSTICS_LAST_REJOIN_TIME, ZCL_DATATYPE_UINT32, (void *)(&network_metrics.last_rejoin_time_ms)},
+    {ATTRID_DIAGNOSTICS_PARENT_ADDR, ZCL_DATATYPE_UINT16, (void *)(&zclDiagnostics_ParentAddr)},
+    {ATTRID_DIAGNOSTICS_APS_ACK_FAILURES, ZCL_DATATYPE_UINT16, (void *)(&network_metrics.aps_ack_failures)},
+};
+
+ZCL_REPORT_FRAME_DECLARE(zclDiagnostics_ReportStorage, ZCL_DIAGNOSTICS_NUM_ATTRS);
+ZCL_REPORT_FRAME_DECLARE(zclDiagnostics_MsReportStorage, ZCL_DIAGNOSTICS_MS_NUM_ATTRS);
+static zclReportCmd_t *zclDiagnostics_ReportFrame = NULL;
+static zclReportCmd_t *zclDiagnostics_MsReportFrame = NULL;
+
+// Values as last reported - the baseline for the change thresholds
+static NetworkMetrics_t zclDiagnostics_Reported;
+static uint16 zclDiagnostics_ReportedParent = 0xFFFF;
+static uint32 zclDiagnostics_LastReport = 0;
+static bool zclDiagnostics_EverReported = false;
+
+static bool zclDiagnostics_Changed(void) {
+    const NetworkMetrics_t *m = &network_metrics;
+    const NetworkMetrics_t *r = &zclDiagnostics_Reported;
+    uint8 lqiDelta = (m->parent_lqi > r->parent_lqi) ? (m->parent_lqi - r->parent_lqi) : (r->parent_lqi - m->parent_lqi);
+
+    return lqiDelta >= ZCL_DIAGNOSTICS_LQI_CHANGE || m->rejoin_attempts != r->rejoin_attempts ||
+           m->rejoin_successes != r->rejoin_successes || m->rejoin_failures != r->rejoin_failures ||
+           m->consecutive_failures != r->consecutive_failures || m->current_tx_power != r->current_tx_power ||
+           m->last_channel != r->last_channel || m->parent_switches != r->parent_switches ||
+           m->aps_ack_failures != r->aps_ack_failures || zclDiagnostics_ParentAddr != zclDiagnostics_ReportedParent;
+}
+
+bool zclDiagnostics_Update(void) {
+    if (devState != DEV_END_DEVICE) {
+        return false;
+    }
+    zclDiagnostics_ParentAddr = _NIB.nwkCoordAddress;
+
+    uint32 now = osal_GetSystemClock();
+    uint32 sinceLast = now - zclDiagnostics_LastReport;
+    // Low battery tiers report less often
+    if (zclDiagnostics_EverReported && sinceLast < zclPowerProfile_ScaleInterval(ZCL_DIAGNOSTICS_MIN_INTERVAL)) {
+        return false;
+    }
+    bool due = !zclDiagnostics_EverReported || zclDiagnostics_Changed() ||
+               (ZCL_DIAGNOSTICS_MAX_INTERVAL != 0 && sinceLast >= zclPowerProfile_ScaleInterval(ZCL_DIAGNOSTICS_MAX_INTERVAL));
+    if (!due) {
+        return false;
+    }
+
+    if (zclDiagnostics_ReportFrame == NULL) {
+        zclDiagnostics_ReportFrame =
+            zclReportFrame_Build(zclDiagnostics_ReportStorage, zclDiagnostics_ReportBindings, ZCL_DIAGNOSTICS_NUM_ATTRS);
+        zclDiagnostics_MsReportFrame = zclReportFrame_Build(zclDiagnostics_MsReportStorage, zclDiagnostics_MsReportBindings,
+                                                            ZCL_DIAGNOSTICS_MS_NUM_ATTRS);
+    }
+    // Either cluster may be bound on its own
+    ZStatus_t std = zclReportFrame_SendClass(ZCL_DIAGNOSTICS_ENDPOINT, ZCL_CLUSTER_ID_DIAGNOSTICS, zclDiagnostics_ReportFrame,
+                                             ZCL_DIAGNOSTICS_REPORT_CLASS);
+    ZStatus_t ms = zclReportFrame_SendClass(ZCL_DIAGNOSTICS_ENDPOINT, ZCL_DIAGNOSTICS_MS_CLUSTER, zclDiagnostics_MsReportFrame,
+                                            ZCL_DIAGNOSTICS_REPORT_CLASS);
+    if (std != ZSuccess && ms != ZSuccess) {
+        return false; // e.g. not bound yet - keep the old baseline
+    }
+    LREP("Diagnostics report lqi=%d rejoins=%d/%d\r\n", network_metrics.parent_lqi, network_metrics.rejoin_successes,
+         network_metrics.rejoin_attempts);
+    zclDiagnostics_Reported = network_metrics;
+    zclDiagnostics_ReportedParent = zclDiagnostics_ParentAddr;
+    zclDiagnostics_LastReport = now;
+    zclDiagnostics_EverReported = true;
+    return true;
+}
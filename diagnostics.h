@@ -0,0 +1,99 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "zcl.h"
+#include "commissioning.h"
+#include "report_frame.h"
+#include "telemetry.h"
+
+/*
+ * Network diagnostics over ZCL: NetworkMetrics_t split across two clusters.
+ * The standard Diagnostics cluster (0x0B05) carries only standard attributes
+ * (LastMessageLQI). The rejoin, TX power and parent-switch counters live on
+ * the manufacturer cluster (ZCL_DIAGNOSTICS_MS_CLUSTER, the telemetry cluster
+ * by default), so nothing lands in 0x0B05's global attribute range. Paste
+ * both ZCL_DIAGNOSTICS_ATTR_RECORDS and ZCL_DIAGNOSTICS_MS_ATTR_RECORDS into
+ * the app attribute table and call zclDiagnostics_Update() from the report
+ * cycle; each cluster reports to its bound destinations when a value moved
+ * past its threshold.
+ */
+
+#ifndef ZCL_CLUSTER_ID_DIAGNOSTICS
+    #define ZCL_CLUSTER_ID_DIAGNOSTICS 0x0B05
+#endif
+
+#ifndef ZCL_DIAGNOSTICS_ENDPOINT
+    #define ZCL_DIAGNOSTICS_ENDPOINT 1
+#endif
+
+// Manufacturer cluster for the non-standard counters (frames not marked manufacturer-specific, like telemetry)
+#ifndef ZCL_DIAGNOSTICS_MS_CLUSTER
+    #define ZCL_DIAGNOSTICS_MS_CLUSTER ZCL_CLUSTER_ID_TELEMETRY
+#endif
+
+// Standard attributes (0x0B05)
+#define ATTRID_DIAGNOSTICS_LAST_MESSAGE_LQI 0x011C
+// Manufacturer attributes (ZCL_DIAGNOSTICS_MS_CLUSTER)
+#define ATTRID_DIAGNOSTICS_REJOIN_ATTEMPTS      0x0000
+#define ATTRID_DIAGNOSTICS_REJOIN_SUCCESSES     0x0001
+#define ATTRID_DIAGNOSTICS_REJOIN_FAILURES      0x0002
+#define ATTRID_DIAGNOSTICS_CONSECUTIVE_FAILURES 0x0003
+#define ATTRID_DIAGNOSTICS_TX_POWER             0x0004 // dBm
+#define ATTRID_DIAGNOSTICS_CHANNEL              0x0005
+#define ATTRID_DIAGNOSTICS_PARENT_SWITCHES      0x0006
+#define ATTRID_DIAGNOSTICS_LAST_SWITCH_REASON   0x0007 // PARENT_SWITCH_REASON_*
+#define ATTRID_DIAGNOSTICS_LAST_REJOIN_TIME     0x0008 // ms
+#define ATTRID_DIAGNOSTICS_PARENT_ADDR          0x0009
+#define ATTRID_DIAGNOSTICS_APS_ACK_FAILURES     0x000A
+
+#define ZCL_DIAGNOSTICS_NUM_ATTRS 1
+#define ZCL_DIAGNOSTICS_MS_NUM_ATTRS 11
+
+#define ZCL_DIAGNOSTICS_ATTR(clusterId, attrId, dataType, ptr)                                                                   \
+    { clusterId, { attrId, dataType, ACCESS_CONTROL_READ | ACCESS_REPORTABLE, (void *)(ptr) } }
+
+// Attribute records for the app attribute table - standard Diagnostics cluster
+#define ZCL_DIAGNOSTICS_ATTR_RECORDS                                                                                             \
+    ZCL_DIAGNOSTICS_ATTR(ZCL_CLUSTER_ID_DIAGNOSTICS, ATTRID_DIAGNOSTICS_LAST_MESSAGE_LQI, ZCL_DATATYPE_UINT8,                    \
+                         &network_metrics.parent_lqi)
+
+// ... and the manufacturer cluster
+#define ZCL_DIAGNOSTICS_MS_ATTR(attrId, dataType, ptr) ZCL_DIAGNOSTICS_ATTR(ZCL_DIAGNOSTICS_MS_CLUSTER, attrId, dataType, ptr)
+#define ZCL_DIAGNOSTICS_MS_ATTR_RECORDS                                                                                          \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_REJOIN_ATTEMPTS, ZCL_DATATYPE_UINT16, &network_metrics.rejoin_attempts),          \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_REJOIN_SUCCESSES, ZCL_DATATYPE_UINT16, &network_metrics.rejoin_successes),        \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_REJOIN_FAILURES, ZCL_DATATYPE_UINT16, &network_metrics.rejoin_failures),          \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_CONSECUTIVE_FAILURES, ZCL_DATATYPE_UINT16, &network_metrics.consecutive_failures), \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_TX_POWER, ZCL_DATATYPE_INT8, &network_metrics.current_tx_power),                  \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_CHANNEL, ZCL_DATATYPE_UINT8, &network_metrics.last_channel),                      \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_PARENT_SWITCHES, ZCL_DATATYPE_UINT16, &network_metrics.parent_switches),          \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_LAST_SWITCH_REASON, ZCL_DATATYPE_ENUM8, &network_metrics.last_switch_reason),     \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_LAST_REJOIN_TIME, ZCL_DATATYPE_UINT32, &network_metrics.last_rejoin_time_ms),     \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_PARENT_ADDR, ZCL_DATATYPE_UINT16, &zclDiagnostics_ParentAddr),                    \
+    ZCL_DIAGNOSTICS_MS_ATTR(ATTRID_DIAGNOSTICS_APS_ACK_FAILURES, ZCL_DATATYPE_UINT16, &network_metrics.aps_ack_failures)
+
+// Reportable change: parent LQI moves by this much; counters, channel, TX power on any change
+#ifndef ZCL_DIAGNOSTICS_LQI_CHANGE
+    #define ZCL_DIAGNOSTICS_LQI_CHANGE 16
+#endif
+// No more than one report per min interval; one at least every max interval (0 = only on change)
+#ifndef ZCL_DIAGNOSTICS_MIN_INTERVAL
+    #define ZCL_DIAGNOSTICS_MIN_INTERVAL ((uint32)60000) // 1 minute
+#endif
+#ifndef ZCL_DIAGNOSTICS_MAX_INTERVAL
+    #define ZCL_DIAGNOSTICS_MAX_INTERVAL ((uint32)21600000) // 6 hours
+#endif
+
+// Counters are cumulative, so a lost report is covered by the next one
+#ifndef ZCL_DIAGNOSTICS_REPORT_CLASS
+    #define ZCL_DIAGNOSTICS_REPORT_CLASS ZCL_REPORT_CLASS_FIRE_AND_FORGET
+#endif
+
+// Current parent short address (ATTRID_DIAGNOSTICS_PARENT_ADDR), refreshed by zclDiagnostics_Update
+extern uint16 zclDiagnostics_ParentAddr;
+
+// Report if any metric moved past its threshold (or the max interval passed). TRUE if a report went out
+// on either cluster.
+extern bool zclDiagnostics_Update(void);
+
+#endif
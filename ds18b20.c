@@ -1,5 +1,7 @@
 #include "ds18b20.h"
 #include "OnBoard.h"
+#include "power_profile.h"
+#include "battery_forecast.h"
 
 #define DS18B20_SKIP_ROM 0xCC
 #define DS18B20_CONVERT_T 0x44
@@ -24,6 +26,9 @@
 
 #define DS18B20_RETRY_DELAY ((uint16) (MAX_CONVERSION_TIME / DS18B20_RETRY_COUNT))  // 300ms per retry
 
+// Resolution register steps by 0x20 per bit (9-bit 0x1F ... 12-bit 0x7F)
+#define DS18B20_RESOLUTION_STEP 0x20
+
 static void _delay_us(uint16);
 static void _delay_ms(uint16);
 static void ds18b20_send(uint8);
@@ -133,7 +138,18 @@ static void ds18b20_GroudPins(void) {
     TSENS_DIR &= ~TSENS_BV; // input
 }
 
+// Conversion time halves with every bit dropped: 750/375/188/94ms
+static uint16 ds18b20_retryDelay(uint8 resolution) {
+    uint8 shift = (DS18B20_TEMP_12_BIT - resolution) / DS18B20_RESOLUTION_STEP;
+    return DS18B20_RETRY_DELAY >> shift;
+}
+
 void ds18b20_setResolution(uint8 resolution) {
+    // Low battery: trade resolution for shorter (blocking, awake) conversions
+    uint8 drop = zclPowerProfile_ResolutionDrop();
+    while (drop-- && resolution > DS18B20_TEMP_9_BIT) {
+        resolution -= DS18B20_RESOLUTION_STEP;
+    }
     ds18b20_current_resolution = resolution;
     ds18b20_Reset();
     ds18b20_send_byte(DS18B20_SKIP_ROM);
@@ -171,7 +187,7 @@ static int16 ds18b20_convertTemperature(uint8 temp1, uint8 temp2, uint8 resoluti
 }
 
 int16 readTemperature(void) {
-    // WARNING: This function BLOCKS for up to 900ms (3 retries × 300ms)
+    // WARNING: This function BLOCKS for up to 900ms (3 retries × 300ms at 12-bit)
     // during temperature conversion. This may cause Zigbee message loss.
     // Keep DS18B20 reads infrequent to minimize network impact.
     // Resolution must be set by caller before invoking (e.g. ds18b20_setResolution).
@@ -181,9 +197,12 @@ int16 readTemperature(void) {
 
     ds18b20_send_byte(DS18B20_SKIP_ROM);
     ds18b20_send_byte(DS18B20_CONVERT_T);
+    zclBatteryForecast_CountActivity(BATTERY_ACTIVITY_SENSOR_CONVERSION);
 
     while (retry_count) {
-        _delay_ms(DS18B20_RETRY_DELAY);  // BLOCKS for 300ms per iteration
+        uint16 wait = ds18b20_retryDelay(ds18b20_current_resolution);
+        _delay_ms(wait);  // BLOCKS for up to 300ms per iteration
+        zclBatteryForecast_AddAwakeTime(wait); // busy wait - the MCU stays awake
         ds18b20_Reset();
         ds18b20_send_byte(DS18B20_SKIP_ROM);
         ds18b20_send_byte(DS18B20_READ_SCRATCHPAD);
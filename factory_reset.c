@@ -9,6 +9,12 @@
 #include "ZComDef.h"
 #include "hal_key.h"
 #include "commissioning.h"
+#include "OSAL_Nv.h"
+#ifdef FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE
+#include "hal_adc.h"
+#include "hal_flash.h"
+#include "hal_mcu.h"
+#endif
 
 static void zclFactoryResetter_ResetToFN(void);
 static void zclFactoryResetter_ProcessBootCounter(void);
@@ -46,10 +52,74 @@ uint16 zclFactoryResetter_loop(uint8 task_id, uint16 events) {
     }
     return 0;
 }
+#ifdef FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE
+/*
+ * Boot counter journal: the page is read as 4-byte words from the start.
+ *   0x00000000 - one boot
+ *   0xFFFFFFFF - erased, end of journal
+ *   any other  - counter cleared (also what a torn boot write looks like, so
+ *                an interrupted write can only undercount, never trigger a reset)
+ * An increment or a clear programs one word; the page is erased only once full.
+ * Like osal_nv_write, nothing is written below VDD_MIN_NV: a device browning out
+ * in a reboot loop would otherwise tear the erase.
+ */
+#define BOOTCOUNTER_JOURNAL_WORDS (HAL_FLASH_PAGE_SIZE / HAL_FLASH_WORD_SIZE)
+#define BOOTCOUNTER_WORD_BOOT 0x00000000UL
+#define BOOTCOUNTER_WORD_ERASED 0xFFFFFFFFUL
+#define BOOTCOUNTER_WORD_CLEAR 0x5AA55AA5UL
+
+static uint16 bootCounterJournalNext = 0;  // index of the first erased word
+static uint16 bootCounterJournalCount = 0; // boots since the last clear
+
+static void zclFactoryResetter_JournalProgram(uint32 word) {
+    uint16 addr = (uint16)(((uint32)FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE * HAL_FLASH_PAGE_SIZE) / HAL_FLASH_WORD_SIZE) +
+                  bootCounterJournalNext;
+    HalFlashWrite(addr, (uint8 *)&word, 1);
+    bootCounterJournalNext++;
+    bootCounterJournalCount = (word == BOOTCOUNTER_WORD_BOOT) ? bootCounterJournalCount + 1 : 0;
+}
+
+static void zclFactoryResetter_JournalAppend(uint32 word) {
+    if (!HalAdcCheckVdd(VDD_MIN_NV)) {
+        LREPMaster("Boot counter journal: VDD too low, write skipped\r\n");
+        return; // this boot goes uncounted - undercounting never triggers a reset
+    }
+    if (bootCounterJournalNext >= BOOTCOUNTER_JOURNAL_WORDS) {
+        // Page full: erase and carry the running count over to the fresh page
+        uint16 carry = (word == BOOTCOUNTER_WORD_BOOT) ? bootCounterJournalCount : 0;
+        HalFlashErase(FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE);
+        bootCounterJournalNext = 0;
+        bootCounterJournalCount = 0;
+        while (carry--) {
+            zclFactoryResetter_JournalProgram(BOOTCOUNTER_WORD_BOOT);
+        }
+    }
+    zclFactoryResetter_JournalProgram(word);
+}
+
+static uint16 zclFactoryResetter_JournalCount(void) {
+    uint32 word;
+    bootCounterJournalCount = 0;
+    for (bootCounterJournalNext = 0; bootCounterJournalNext < BOOTCOUNTER_JOURNAL_WORDS; bootCounterJournalNext++) {
+        HalFlashRead(FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE, bootCounterJournalNext * HAL_FLASH_WORD_SIZE, (uint8 *)&word,
+                     HAL_FLASH_WORD_SIZE);
+        if (word == BOOTCOUNTER_WORD_ERASED) {
+            break;
+        }
+        bootCounterJournalCount = (word == BOOTCOUNTER_WORD_BOOT) ? bootCounterJournalCount + 1 : 0;
+    }
+    return bootCounterJournalCount;
+}
+#endif
+
 void zclFactoryResetter_ResetBootCounter(void) {
-    uint16 bootCnt = 0;
     LREPMaster("Clear boot counter\r\n");
+#ifdef FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE
+    zclFactoryResetter_JournalAppend(BOOTCOUNTER_WORD_CLEAR);
+#else
+    uint16 bootCnt = 0;
     osal_nv_write(ZCD_NV_BOOTCOUNTER, 0, sizeof(bootCnt), &bootCnt);
+#endif
 }
 
 void zclFactoryResetter_Init(uint8 task_id) {
@@ -117,10 +187,15 @@ void zclFactoryResetter_ProcessBootCounter(void) {
     LREPMaster("zclFactoryResetter_ProcessBootCounter\r\n");
     osal_start_timerEx(zclFactoryResetter_TaskID, FACTORY_BOOTCOUNTER_RESET_EVT, FACTORY_RESET_BOOTCOUNTER_RESET_TIME);
 
+#ifdef FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE
+    uint16 bootCnt = zclFactoryResetter_JournalCount();
+#else
+    // Own 2-byte item: a write per boot would otherwise rewrite the whole library state record
     uint16 bootCnt = 0;
     if (osal_nv_item_init(ZCD_NV_BOOTCOUNTER, sizeof(bootCnt), &bootCnt) == ZSUCCESS) {
         osal_nv_read(ZCD_NV_BOOTCOUNTER, 0, sizeof(bootCnt), &bootCnt);
     }
+#endif
     LREP("bootCnt %d\r\n", bootCnt);
     bootCnt += 1;
     if (bootCnt >= FACTORY_RESET_BOOTCOUNTER_MAX_VALUE) {
@@ -129,5 +204,9 @@ void zclFactoryResetter_ProcessBootCounter(void) {
         osal_stop_timerEx(zclFactoryResetter_TaskID, FACTORY_BOOTCOUNTER_RESET_EVT);
         osal_start_timerEx(zclFactoryResetter_TaskID, FACTORY_RESET_EVT, 5000);
     }
+#ifdef FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE
+    zclFactoryResetter_JournalAppend(bootCnt ? BOOTCOUNTER_WORD_BOOT : BOOTCOUNTER_WORD_CLEAR);
+#else
     osal_nv_write(ZCD_NV_BOOTCOUNTER, 0, sizeof(bootCnt), &bootCnt);
+#endif
 }
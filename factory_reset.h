@@ -21,6 +21,11 @@
     #define FACTORY_RESET_BOOTCOUNTER_RESET_TIME 10 * 1000
 #endif
 
+// Optional: keep the boot counter in a dedicated, linker-reserved flash page as an
+// append-only journal (one 4-byte word programmed per boot, page erased only when full)
+// instead of rewriting the NV record twice per power-up. Define to the page number.
+// #define FACTORY_RESET_BOOTCOUNTER_FLASH_PAGE 120
+
 #ifndef FACTORY_RESET_BY_LONG_PRESS
     #define FACTORY_RESET_BY_LONG_PRESS TRUE
 #endif
@@ -13,6 +13,7 @@
  *********************************************************************/
 
 #include "led_breathing.h"
+#include "power_profile.h"
 #include "hal_board_cfg.h"
 #include "hal_led.h"
 #include "OSAL.h"
@@ -21,10 +22,27 @@
 /* Slow blink: 500ms ON, 500ms OFF = 1 Hz blink rate */
 #define LED_BREATHING_STEP_MS  500
 
+/* Low-battery tiers: short ON pulse, same or slower cadence */
+#define LED_BREATHING_SAVER_ON_MS     100
+#define LED_BREATHING_SAVER_OFF_MS    900
+#define LED_BREATHING_CRITICAL_ON_MS  50
+#define LED_BREATHING_CRITICAL_OFF_MS 1950
+
 static uint8 led_breathing_task_id = 0;
 static bool led_breathing_active = false;
 static bool led_state_on = false;
 
+static uint16 led_breathing_step_ms(bool on) {
+    switch (zclPowerProfile_Current) {
+    case POWER_PROFILE_SAVER:
+        return on ? LED_BREATHING_SAVER_ON_MS : LED_BREATHING_SAVER_OFF_MS;
+    case POWER_PROFILE_CRITICAL:
+        return on ? LED_BREATHING_CRITICAL_ON_MS : LED_BREATHING_CRITICAL_OFF_MS;
+    default:
+        return LED_BREATHING_STEP_MS;
+    }
+}
+
 void led_breathing_init(uint8 task_id) {
     led_breathing_task_id = task_id;
 }
@@ -36,7 +54,7 @@ void led_breathing_start(void) {
     led_breathing_active = true;
     led_state_on = true;
     HalLedSet(HAL_LED_1, HAL_LED_MODE_ON);
-    osal_start_timerEx(led_breathing_task_id, LED_BREATHING_EVT, LED_BREATHING_STEP_MS);
+    osal_start_timerEx(led_breathing_task_id, LED_BREATHING_EVT, led_breathing_step_ms(true));
 }
 
 void led_breathing_stop(void) {
@@ -60,7 +78,7 @@ uint16 led_breathing_event_loop(uint8 task_id, uint16 events) {
             /* Toggle LED using direct GPIO set — no HAL blink timers */
             led_state_on = !led_state_on;
             HalLedSet(HAL_LED_1, led_state_on ? HAL_LED_MODE_ON : HAL_LED_MODE_OFF);
-            osal_start_timerEx(led_breathing_task_id, LED_BREATHING_EVT, LED_BREATHING_STEP_MS);
+            osal_start_timerEx(led_breathing_task_id, LED_BREATHING_EVT, led_breathing_step_ms(led_state_on));
         }
         return (events ^ LED_BREATHING_EVT);
     }
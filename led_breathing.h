@@ -4,7 +4,7 @@
 #include "hal_types.h"
 
 // LED Breathing event for OSAL — runs on commissioning task
-// Must not conflict with commissioning events (0x0001-0x0010) or factory_reset events (0x1000-0x4000)
+// Must not conflict with commissioning events (0x0001-0x0010, 0x0040-0x0080), POLL_ARBITER_EVT (0x0100) or factory_reset events (0x1000-0x4000)
 #define LED_BREATHING_EVT 0x0020
 
 // Function prototypes
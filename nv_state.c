@@ -0,0 +1,129 @@
+/*********************************************************************
+ * Packed, versioned and checksummed NV record for library state
+ *
+ * Rejoin backoff, last channel, candidate parents and network metrics
+ * used to live in separate NV items, each costing a read
+ * and an init on every boot. They now share one record read with a
+ * single NV access. The legacy items are migrated into it once and then
+ * deleted. The CRC rejects a torn or foreign record, and the build hash
+ * tells the caller when firmware changed under the stored state.
+ *********************************************************************/
+
+#include "nv_state.h"
+#include "OSAL.h"
+#include "OSAL_Nv.h"
+#include "Debug.h"
+
+#define NV_STATE_HEADER_LEN 6 // version, reserved, length, crc
+
+NvStateRecord_t nvState;
+
+static bool nvState_loaded = false;
+static bool nvState_fwChanged = false;
+
+static uint16 nvState_Crc(const uint8 *data, uint16 len) {
+    uint16 crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16)(*data++) << 8;
+        for (uint8 i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16)((crc << 1) ^ 0x1021) : (uint16)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16 nvState_BuildHash(void) {
+    static const char build[] = NV_STATE_BUILD_ID;
+    return nvState_Crc((const uint8 *)build, sizeof(build) - 1);
+}
+
+static void nvState_Defaults(void) {
+    osal_memset(&nvState, 0, sizeof(nvState));
+    for (uint8 i = 0; i < APP_COMMISSIONING_PARENT_CANDIDATES; i++) {
+        nvState.candidates[i].short_addr = INVALID_NODE_ADDR;
+    }
+}
+
+// Read a legacy item into dst only if it exists and fits, then drop it. A shorter item is
+// read as a prefix (NetworkMetrics_t has grown since); the rest keeps its default.
+static void nvState_MigrateItem(uint16 id, void *dst, uint16 len) {
+    uint16 stored = osal_nv_item_len(id);
+    if (stored == 0) {
+        return;
+    }
+    if (stored <= len) {
+        osal_nv_read(id, 0, stored, dst);
+    }
+    osal_nv_delete(id, stored);
+}
+
+static void nvState_MigrateLegacy(void) {
+    LREPMaster("NV: migrating legacy items\r\n");
+    nvState_MigrateItem(ZCD_NV_NETWORK_METRICS, &nvState.metrics, sizeof(NetworkMetrics_t));
+    nvState_MigrateItem(ZCD_NV_LAST_CHANNEL, &nvState.last_channel, sizeof(nvState.last_channel));
+    nvState_MigrateItem(ZCD_NV_REJOIN_BACKOFF_STATE, &nvState.backoff, sizeof(RejoinBackoffState_t));
+    // The old stamp was never written by released firmware, but clear it if present
+    uint16 stamp = osal_nv_item_len(ZCD_NV_FW_VERSION_STAMP);
+    if (stamp != 0) {
+        osal_nv_delete(ZCD_NV_FW_VERSION_STAMP, stamp);
+    }
+}
+
+// Read the stored record; false if missing, torn or from newer firmware
+static bool nvState_Read(void) {
+    uint16 stored = osal_nv_item_len(ZCD_NV_LIB_STATE);
+    if (stored <= NV_STATE_HEADER_LEN || stored > sizeof(nvState)) {
+        return false;
+    }
+    if (osal_nv_read(ZCD_NV_LIB_STATE, 0, stored, &nvState) != SUCCESS || nvState.length != stored ||
+        nvState.version != NV_STATE_VERSION) {
+        return false;
+    }
+    return nvState.crc == nvState_Crc((uint8 *)&nvState + NV_STATE_HEADER_LEN, stored - NV_STATE_HEADER_LEN);
+}
+
+bool nvState_Init(void) {
+    if (nvState_loaded) {
+        return nvState_fwChanged;
+    }
+    nvState_loaded = true;
+
+    uint16 stored = osal_nv_item_len(ZCD_NV_LIB_STATE);
+    if (!nvState_Read()) {
+        nvState_Defaults();
+        if (stored == 0) {
+            nvState_MigrateLegacy();
+        } else {
+            LREP("NV: record invalid (len=%d), starting fresh\r\n", stored);
+        }
+        nvState.build_hash = nvState_BuildHash();
+        nvState_Save();
+        return false;
+    }
+
+    // Shorter record from older firmware: fields past its end were never written
+    if (stored < sizeof(nvState)) {
+        osal_memset((uint8 *)&nvState + stored, 0, sizeof(nvState) - stored);
+    }
+
+    uint16 hash = nvState_BuildHash();
+    if (nvState.build_hash != hash) {
+        LREPMaster("NV: firmware changed since last boot\r\n");
+        nvState.build_hash = hash;
+        nvState_Save();
+        nvState_fwChanged = true;
+    }
+    return nvState_fwChanged;
+}
+
+void nvState_Save(void) {
+    uint16 stored = osal_nv_item_len(ZCD_NV_LIB_STATE);
+    if (stored != 0 && stored != sizeof(nvState)) {
+        osal_nv_delete(ZCD_NV_LIB_STATE, stored); // record grew with a firmware update
+    }
+    nvState.version = NV_STATE_VERSION;
+    nvState.length = sizeof(nvState);
+    nvState.crc = nvState_Crc((uint8 *)&nvState + NV_STATE_HEADER_LEN, sizeof(nvState) - NV_STATE_HEADER_LEN);
+    osal_nv_item_init(ZCD_NV_LIB_STATE, sizeof(nvState), &nvState);
+    osal_nv_write(ZCD_NV_LIB_STATE, 0, sizeof(nvState), &nvState);
+}
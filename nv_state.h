@@ -0,0 +1,42 @@
+#ifndef NV_STATE_H
+#define NV_STATE_H
+
+#include "hal_types.h"
+#include "commissioning.h"
+
+// One NV item holding all persistent library state
+#define ZCD_NV_LIB_STATE 0x040B
+
+// Bump only when an existing field changes meaning or moves; appending a field does not need it
+#define NV_STATE_VERSION 1
+
+// Build identity used to detect a firmware update. Define it from the build system (e.g. the
+// app's date code or a git hash). The fallback is this file's own compile time, so an update
+// that doesn't rebuild nv_state.c - an incremental build touching only the app - goes unnoticed.
+#ifndef NV_STATE_BUILD_ID
+    #define NV_STATE_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+// Append-only layout: new fields go at the end (NetworkMetrics_t is last and may
+// grow too). An older, shorter record is read as a prefix and the tail is zeroed.
+typedef struct {
+    uint8 version;                  // NV_STATE_VERSION
+    uint8 reserved;
+    uint16 length;                  // bytes stored, header included
+    uint16 crc;                     // CRC-16/CCITT over everything after this field
+    uint16 build_hash;              // hash of NV_STATE_BUILD_ID when last written
+    uint8 last_channel;
+    RejoinBackoffState_t backoff;   // rejoinDelay == 0: nothing saved
+    ParentCandidate_t candidates[APP_COMMISSIONING_PARENT_CANDIDATES];
+    NetworkMetrics_t metrics;
+} NvStateRecord_t;
+
+extern NvStateRecord_t nvState;
+
+// Load the record once (later calls only repeat the result), migrating the legacy items on
+// first boot. Returns true if the firmware build changed since the record was written.
+extern bool nvState_Init(void);
+// Seal and write the whole record in one NV access
+extern void nvState_Save(void);
+
+#endif
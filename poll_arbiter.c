@@ -0,0 +1,206 @@
+/*********************************************************************
+ * Poll-rate arbiter for sleepy end devices
+ *
+ * Pairing, the post-join interview, button presses and data bursts all
+ * want a faster poll for a while. Setting NLME_SetPollRate directly from
+ * each of them let the last caller win: a 3 s button revert could cut a
+ * pairing window short. Clients now post a request (rate, priority,
+ * expiry) into their own slot. The arbiter applies the winning request,
+ * and once none is active it drops straight back to the slowest
+ * permitted rate (the long poll - POLL_RATE unless Poll Control set it -
+ * scaled by the power profile).
+ *********************************************************************/
+
+#include "poll_arbiter.h"
+#include "power_profile.h"
+#include "Debug.h"
+#include "OSAL.h"
+#include "ZComDef.h"
+#include "nwk_util.h"
+
+typedef struct {
+    uint32 rate;
+    uint32 expiresAt; // osal_GetSystemClock() time, 0 = until released
+    uint8 priority;   // 0 = slot free
+} PollRequest_t;
+
+static uint8 pollArbiter_TaskId = 0;
+static PollRequest_t pollArbiter_Requests[POLL_ARBITER_CLIENTS];
+static uint32 pollArbiter_Applied = 0;
+static bool pollArbiter_Suspended = false;
+static uint32 pollArbiter_LastPoll = 0;
+static uint32 pollArbiter_CountFrom = 0; // osal_GetSystemClock() the poll count runs from
+static uint32 pollArbiter_Polls = 0;     // polls made at the applied rates, not taken yet
+static uint32 pollArbiter_LongPoll = POLL_RATE;
+static uint32 pollArbiter_LongPollNotified = 0;
+static void (*pollArbiter_LongPollCB)(uint32 rate) = NULL;
+
+// Polls the stack made at the applied rate since the count was last brought up to date
+static void pollArbiter_CountPolls(uint32 now) {
+    if (pollArbiter_Applied == 0) {
+        pollArbiter_CountFrom = now;
+        return;
+    }
+    uint32 polls = (now - pollArbiter_CountFrom) / pollArbiter_Applied;
+    pollArbiter_Polls += polls;
+    pollArbiter_CountFrom += polls * pollArbiter_Applied;
+}
+
+static void pollArbiter_Apply(uint32 rate) {
+    if (rate == pollArbiter_Applied) {
+        return;
+    }
+    LREP("Poll rate %ld -> %ld ms\r\n", pollArbiter_Applied, rate);
+    uint32 now = osal_GetSystemClock();
+    pollArbiter_CountPolls(now);
+    pollArbiter_CountFrom = now; // the poll timer restarts - a partial period makes no poll
+    pollArbiter_Applied = rate;
+#if defined(POWER_SAVING)
+    NLME_SetPollRate(rate);
+    // The stack restarts its poll timer here, so the poll phase runs from now even
+    // if poll confirms never reach us
+    pollArbiter_LastPoll = osal_GetSystemClock();
+#endif
+}
+
+static void pollArbiter_Evaluate(void) {
+    uint32 now = osal_GetSystemClock();
+    uint32 nextExpiry = 0;
+    PollRequest_t *winner = NULL;
+
+    for (uint8 i = 0; i < POLL_ARBITER_CLIENTS; i++) {
+        PollRequest_t *req = &pollArbiter_Requests[i];
+        if (req->priority == 0) {
+            continue;
+        }
+        if (req->expiresAt != 0) {
+            int32 left = (int32)(req->expiresAt - now);
+            if (left <= 0) {
+                req->priority = 0; // expired
+                continue;
+            }
+            if (nextExpiry == 0 || (uint32)left < nextExpiry) {
+                nextExpiry = (uint32)left;
+            }
+        }
+        if (winner == NULL || req->priority > winner->priority ||
+            (req->priority == winner->priority && req->rate < winner->rate)) {
+            winner = req;
+        }
+    }
+
+    uint32 longPoll = pollArbiter_LongPollRate();
+    if (!pollArbiter_Suspended) {
+        pollArbiter_Apply(winner ? winner->rate : longPoll);
+    }
+    if (longPoll != pollArbiter_LongPollNotified) {
+        pollArbiter_LongPollNotified = longPoll;
+        if (pollArbiter_LongPollCB != NULL) {
+            pollArbiter_LongPollCB(longPoll);
+        }
+    }
+
+    if (nextExpiry != 0) {
+        osal_start_timerEx(pollArbiter_TaskId, POLL_ARBITER_EVT, nextExpiry);
+    } else {
+        osal_stop_timerEx(pollArbiter_TaskId, POLL_ARBITER_EVT);
+    }
+}
+
+void pollArbiter_Init(uint8 task_id) {
+    pollArbiter_TaskId = task_id;
+    osal_memset(pollArbiter_Requests, 0, sizeof(pollArbiter_Requests));
+}
+
+void pollArbiter_Request(uint8 client, uint32 rate, uint8 priority, uint32 expiry) {
+    if (client >= POLL_ARBITER_CLIENTS || priority == 0) {
+        return;
+    }
+    PollRequest_t *req = &pollArbiter_Requests[client];
+    req->rate = rate;
+    req->priority = priority;
+    req->expiresAt = expiry ? (osal_GetSystemClock() + expiry) : 0;
+    if (req->expiresAt == 0 && expiry != 0) {
+        req->expiresAt = 1; // clock wrapped onto the "no expiry" marker
+    }
+    pollArbiter_Evaluate();
+}
+
+void pollArbiter_Release(uint8 client) {
+    if (client >= POLL_ARBITER_CLIENTS || pollArbiter_Requests[client].priority == 0) {
+        return;
+    }
+    pollArbiter_Requests[client].priority = 0;
+    pollArbiter_Evaluate();
+}
+
+void pollArbiter_Refresh(void) {
+    pollArbiter_Evaluate();
+}
+
+void pollArbiter_Suspend(void) {
+    if (pollArbiter_Suspended) {
+        return;
+    }
+    pollArbiter_CountPolls(osal_GetSystemClock()); // polls up to the loss did happen
+    pollArbiter_Suspended = true;
+    pollArbiter_Applied = 0; // no polls counted, none planned for the wake scheduler
+    pollArbiter_LastPoll = 0;
+}
+
+void pollArbiter_Resume(void) {
+    if (!pollArbiter_Suspended) {
+        return;
+    }
+    pollArbiter_Suspended = false;
+    pollArbiter_Evaluate(); // Applied is 0, so whatever wins is pushed to the stack
+}
+
+void pollArbiter_SetLongPoll(uint32 rate) {
+    if (rate == 0 || rate == pollArbiter_LongPoll) {
+        return;
+    }
+    pollArbiter_LongPoll = rate;
+    pollArbiter_Evaluate();
+}
+
+uint32 pollArbiter_LongPollRate(void) {
+    return zclPowerProfile_ScaleInterval(pollArbiter_LongPoll);
+}
+
+void pollArbiter_RegisterLongPollCB(void (*pfnCB)(uint32 rate)) {
+    pollArbiter_LongPollCB = pfnCB;
+}
+
+void pollArbiter_OnPollConfirm(uint8 status) {
+    pollArbiter_LastPoll = osal_GetSystemClock();
+    if (status == ZSuccess) {
+        // Parent handed us a frame - more may be queued behind it, drain at the fast rate
+        pollArbiter_Request(POLL_CLIENT_BURST, QUEUED_POLL_RATE, POLL_PRIORITY_HIGH, POLL_ARBITER_BURST_WINDOW);
+    } else if (status == ZMacNoData) {
+        pollArbiter_Release(POLL_CLIENT_BURST); // queue empty
+    }
+}
+
+uint32 pollArbiter_CurrentRate(void) {
+    return pollArbiter_Applied;
+}
+
+uint32 pollArbiter_LastPollTime(void) {
+    return pollArbiter_LastPoll;
+}
+
+uint32 pollArbiter_TakePollCount(void) {
+    pollArbiter_CountPolls(osal_GetSystemClock());
+    uint32 polls = pollArbiter_Polls;
+    pollArbiter_Polls = 0;
+    return polls;
+}
+
+uint16 pollArbiter_event_loop(uint8 task_id, uint16 events) {
+    if (events & POLL_ARBITER_EVT) {
+        pollArbiter_Evaluate();
+        return (events ^ POLL_ARBITER_EVT);
+    }
+    return 0;
+}
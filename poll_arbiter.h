@@ -0,0 +1,58 @@
+#ifndef POLL_ARBITER_H
+#define POLL_ARBITER_H
+
+#include "hal_types.h"
+
+// Poll arbiter event for OSAL — runs on commissioning task
+// Must not conflict with commissioning events (0x0001-0x0010, 0x0040-0x0080), LED_BREATHING_EVT (0x0020)
+// or factory_reset events (0x1000-0x4000)
+#define POLL_ARBITER_EVT 0x0100
+
+// Request slots - one outstanding request per client, a new request replaces the old one
+#define POLL_CLIENT_PAIRING      0
+#define POLL_CLIENT_INTERVIEW    1
+#define POLL_CLIENT_BUTTON       2
+#define POLL_CLIENT_BURST        3 // parent reported more queued data
+#define POLL_CLIENT_POLL_CONTROL 4 // coordinator-requested fast poll (Poll Control cluster)
+#define POLL_CLIENT_APP          5 // free for the application (e.g. awaiting a response)
+#define POLL_ARBITER_CLIENTS     6
+
+// Highest priority active request wins; equal priorities take the faster rate
+#define POLL_PRIORITY_LOW    1
+#define POLL_PRIORITY_NORMAL 2
+#define POLL_PRIORITY_HIGH   3
+
+// Keep fast-polling this long after a poll that returned data, re-armed by each one
+#ifndef POLL_ARBITER_BURST_WINDOW
+    #define POLL_ARBITER_BURST_WINDOW 500
+#endif
+
+extern void pollArbiter_Init(uint8 task_id);
+// rate in ms; expiry in ms from now, 0 = until released
+extern void pollArbiter_Request(uint8 client, uint32 rate, uint8 priority, uint32 expiry);
+extern void pollArbiter_Release(uint8 client);
+// Re-evaluate after an outside change to the fallback (e.g. power profile)
+extern void pollArbiter_Refresh(void);
+// Parent lost: the stack stops polling and later sets its own rate, so forget the applied rate
+// and apply nothing until Resume (requests are still recorded)
+extern void pollArbiter_Suspend(void);
+// Network back: push the winning rate to the stack again
+extern void pollArbiter_Resume(void);
+// Long-poll interval used when no request is active (default POLL_RATE; still scaled by the power profile)
+extern void pollArbiter_SetLongPoll(uint32 rate);
+// Effective long-poll interval (after power-profile scaling) - what the device polls at when idle
+extern uint32 pollArbiter_LongPollRate(void);
+// Notified whenever the effective long-poll interval changes
+extern void pollArbiter_RegisterLongPollCB(void (*pfnCB)(uint32 rate));
+// Status of every data poll - ZSuccess means a frame came back, ZMacNoData that the queue is empty
+extern void pollArbiter_OnPollConfirm(uint8 status);
+// Rate applied to the stack, 0 = none (suspended or not applied yet)
+extern uint32 pollArbiter_CurrentRate(void);
+// osal_GetSystemClock() time of the last data poll - confirmed, or the poll timer restart
+// when the rate was applied - 0 = none yet
+extern uint32 pollArbiter_LastPollTime(void);
+// Data polls made since the last call, from the applied rates (no poll confirm hook needed)
+extern uint32 pollArbiter_TakePollCount(void);
+extern uint16 pollArbiter_event_loop(uint8 task_id, uint16 events);
+
+#endif
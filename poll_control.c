@@ -0,0 +1,217 @@
+/*********************************************************************
+ * ZCL Poll Control cluster server
+ *
+ * Lets a coordinator reach a sleepy device quickly without making it
+ * poll often: the device sends a Check-in every check-in interval and
+ * fast-polls briefly for the answer. A coordinator with commands queued
+ * replies "start fast polling" and gets a burst at the short-poll
+ * interval until Fast Poll Stop or the timeout. Fast polling and the
+ * long-poll interval both go through the poll arbiter, so they compose
+ * with pairing, interview and button requests. Settings persist in NV.
+ *********************************************************************/
+
+#include "poll_control.h"
+#include "poll_arbiter.h"
+#include "power_profile.h"
+#include "report_phase.h"
+#include "wake_scheduler.h"
+#include "Debug.h"
+#include "OSAL.h"
+#include "OSAL_Nv.h"
+#include "ZDApp.h"
+#include "zcl.h"
+#include "bdb_interface.h"
+
+#define QS_TO_MS(qs) ((uint32)(qs) * 250)
+
+typedef struct {
+    uint32 checkInInterval;
+    uint32 longPollInterval;
+    uint16 shortPollInterval;
+    uint16 fastPollTimeout;
+} PollControlSettings_t;
+
+uint32 zclPollControl_CheckInInterval = POLL_CONTROL_DEFAULT_CHECK_IN_INTERVAL;
+uint32 zclPollControl_LongPollInterval = POLL_RATE / 250;
+uint16 zclPollControl_ShortPollInterval = POLL_CONTROL_DEFAULT_SHORT_POLL_INTERVAL;
+uint16 zclPollControl_FastPollTimeout = POLL_CONTROL_DEFAULT_FAST_POLL_TIMEOUT;
+uint32 zclPollControl_CheckInIntervalMin = POLL_CONTROL_CHECK_IN_INTERVAL_MIN;
+uint32 zclPollControl_LongPollIntervalMin = POLL_CONTROL_LONG_POLL_INTERVAL_MIN;
+uint16 zclPollControl_FastPollTimeoutMax = POLL_CONTROL_FAST_POLL_TIMEOUT_MAX;
+
+static uint8 zclPollControl_TaskId = 0;
+static PollControlSettings_t zclPollControl_Stored;
+static afAddrType_t zclPollControl_DstAddr = {.addrMode = (afAddrMode_t)AddrNotPresent, .endPoint = 0, .addr.shortAddr = 0};
+
+static ZStatus_t zclPollControl_HandleIncoming(zclIncoming_t *pInMsg);
+
+static bool zclPollControl_Valid(uint32 checkIn, uint32 longPoll, uint16 shortPoll) {
+    if (checkIn != 0 && (checkIn < zclPollControl_CheckInIntervalMin || longPoll > checkIn)) {
+        return false;
+    }
+    return shortPoll != 0 && longPoll >= zclPollControl_LongPollIntervalMin && longPoll >= shortPoll;
+}
+
+static bool zclPollControl_TimeoutValid(uint16 fastPollTimeout) {
+    return fastPollTimeout != 0 && fastPollTimeout <= zclPollControl_FastPollTimeoutMax;
+}
+
+static void zclPollControl_ScheduleCheckIn(void) {
+    if (zclPollControl_CheckInInterval == 0) {
+        wakeScheduler_Stop(zclPollControl_TaskId, POLL_CONTROL_CHECKIN_EVT);
+    } else {
+        // Check in at this device's slot of the interval so a site's check-ins don't bunch up;
+        // low battery tiers check in less often than the attribute says
+        uint32 interval = zclPowerProfile_ScaleInterval(QS_TO_MS(zclPollControl_CheckInInterval));
+        wakeScheduler_Start(zclPollControl_TaskId, POLL_CONTROL_CHECKIN_EVT, reportPhase_NextDelay(interval),
+                            interval / ((uint32)REPORT_PHASE_SLOTS * POLL_CONTROL_CHECK_IN_TOLERANCE_DIV));
+    }
+}
+
+static void zclPollControl_Save(void) {
+    zclPollControl_Stored.checkInInterval = zclPollControl_CheckInInterval;
+    zclPollControl_Stored.longPollInterval = zclPollControl_LongPollInterval;
+    zclPollControl_Stored.shortPollInterval = zclPollControl_ShortPollInterval;
+    zclPollControl_Stored.fastPollTimeout = zclPollControl_FastPollTimeout;
+    osal_nv_item_init(ZCD_NV_POLL_CONTROL, sizeof(PollControlSettings_t), &zclPollControl_Stored);
+    osal_nv_write(ZCD_NV_POLL_CONTROL, 0, sizeof(PollControlSettings_t), &zclPollControl_Stored);
+}
+
+void zclPollControl_AttributesChanged(void) {
+    if (!zclPollControl_Valid(zclPollControl_CheckInInterval, zclPollControl_LongPollInterval,
+                              zclPollControl_ShortPollInterval) ||
+        !zclPollControl_TimeoutValid(zclPollControl_FastPollTimeout)) {
+        // Reject the write by restoring the last good settings
+        zclPollControl_CheckInInterval = zclPollControl_Stored.checkInInterval;
+        zclPollControl_LongPollInterval = zclPollControl_Stored.longPollInterval;
+        zclPollControl_ShortPollInterval = zclPollControl_Stored.shortPollInterval;
+        zclPollControl_FastPollTimeout = zclPollControl_Stored.fastPollTimeout;
+        return;
+    }
+    if (zclPollControl_Stored.checkInInterval == zclPollControl_CheckInInterval &&
+        zclPollControl_Stored.longPollInterval == zclPollControl_LongPollInterval &&
+        zclPollControl_Stored.shortPollInterval == zclPollControl_ShortPollInterval &&
+        zclPollControl_Stored.fastPollTimeout == zclPollControl_FastPollTimeout) {
+        return;
+    }
+    if (zclPollControl_Stored.checkInInterval != zclPollControl_CheckInInterval) {
+        zclPollControl_ScheduleCheckIn();
+    }
+    zclPollControl_Save();
+    pollArbiter_SetLongPoll(QS_TO_MS(zclPollControl_LongPollInterval));
+    LREP("Poll control: check-in=%ld long=%ld short=%d qs\r\n", zclPollControl_CheckInInterval,
+         zclPollControl_LongPollInterval, zclPollControl_ShortPollInterval);
+}
+
+void zclPollControl_Init(uint8 task_id) {
+    zclPollControl_TaskId = task_id;
+    zcl_registerPlugin(ZCL_CLUSTER_ID_GEN_POLL_CONTROL, ZCL_CLUSTER_ID_GEN_POLL_CONTROL, zclPollControl_HandleIncoming);
+
+    // A corrupted or old item goes through the same checks as a remote write - defaults otherwise
+    if (osal_nv_read(ZCD_NV_POLL_CONTROL, 0, sizeof(PollControlSettings_t), &zclPollControl_Stored) == SUCCESS &&
+        zclPollControl_Valid(zclPollControl_Stored.checkInInterval, zclPollControl_Stored.longPollInterval,
+                             zclPollControl_Stored.shortPollInterval) &&
+        zclPollControl_TimeoutValid(zclPollControl_Stored.fastPollTimeout)) {
+        zclPollControl_CheckInInterval = zclPollControl_Stored.checkInInterval;
+        zclPollControl_LongPollInterval = zclPollControl_Stored.longPollInterval;
+        zclPollControl_ShortPollInterval = zclPollControl_Stored.shortPollInterval;
+        zclPollControl_FastPollTimeout = zclPollControl_Stored.fastPollTimeout;
+    } else {
+        LREPMaster("Poll control: no valid stored settings, using defaults\r\n");
+        zclPollControl_Stored.checkInInterval = zclPollControl_CheckInInterval;
+        zclPollControl_Stored.longPollInterval = zclPollControl_LongPollInterval;
+        zclPollControl_Stored.shortPollInterval = zclPollControl_ShortPollInterval;
+        zclPollControl_Stored.fastPollTimeout = zclPollControl_FastPollTimeout;
+    }
+
+    pollArbiter_SetLongPoll(QS_TO_MS(zclPollControl_LongPollInterval));
+    zclPollControl_ScheduleCheckIn();
+}
+
+static void zclPollControl_CheckIn(void) {
+    if (devState != DEV_END_DEVICE) {
+        return; // not on a network - try again next interval
+    }
+    LREP("Poll control: check-in\r\n");
+    zcl_SendCommand(POLL_CONTROL_ENDPOINT, &zclPollControl_DstAddr, ZCL_CLUSTER_ID_GEN_POLL_CONTROL,
+                    COMMAND_POLL_CONTROL_CHECK_IN, TRUE, ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, 0, bdb_getZCLFrameCounter(), 0,
+                    NULL);
+    // Stay reachable for the Check-in Response - up to the fast poll timeout, within sane bounds;
+    // the response itself ends or replaces this request
+    uint32 wait = QS_TO_MS(zclPollControl_FastPollTimeout);
+    wait = MAX(wait, POLL_CONTROL_CHECK_IN_RSP_WAIT_MIN);
+    wait = MIN(wait, POLL_CONTROL_CHECK_IN_RSP_WAIT_MAX);
+    pollArbiter_Request(POLL_CLIENT_POLL_CONTROL, QS_TO_MS(zclPollControl_ShortPollInterval), POLL_PRIORITY_HIGH, wait);
+}
+
+static ZStatus_t zclPollControl_HandleIncoming(zclIncoming_t *pInMsg) {
+    if (pInMsg->hdr.fc.direction != ZCL_FRAME_CLIENT_SERVER_DIR) {
+        return ZFailure;
+    }
+    uint8 *pData = pInMsg->pData;
+
+    switch (pInMsg->hdr.commandID) {
+    case COMMAND_POLL_CONTROL_CHECK_IN_RSP: {
+        if (pInMsg->pDataLen < 3) {
+            return ZCL_STATUS_MALFORMED_COMMAND;
+        }
+        uint16 timeout = BUILD_UINT16(pData[1], pData[2]);
+        if (!pData[0]) {
+            pollArbiter_Release(POLL_CLIENT_POLL_CONTROL);
+            return ZSuccess;
+        }
+        if (timeout == 0) {
+            timeout = zclPollControl_FastPollTimeout;
+        }
+        if (timeout > zclPollControl_FastPollTimeoutMax) {
+            return ZCL_STATUS_INVALID_VALUE;
+        }
+        LREP("Poll control: fast poll for %d qs\r\n", timeout);
+        pollArbiter_Request(POLL_CLIENT_POLL_CONTROL, QS_TO_MS(zclPollControl_ShortPollInterval), POLL_PRIORITY_HIGH,
+                            QS_TO_MS(timeout));
+        return ZSuccess;
+    }
+
+    case COMMAND_POLL_CONTROL_FAST_POLL_STOP:
+        pollArbiter_Release(POLL_CLIENT_POLL_CONTROL);
+        return ZSuccess;
+
+    case COMMAND_POLL_CONTROL_SET_LONG_POLL_INTERVAL: {
+        if (pInMsg->pDataLen < 4) {
+            return ZCL_STATUS_MALFORMED_COMMAND;
+        }
+        uint32 interval = BUILD_UINT32(pData[0], pData[1], pData[2], pData[3]);
+        if (!zclPollControl_Valid(zclPollControl_CheckInInterval, interval, zclPollControl_ShortPollInterval)) {
+            return ZCL_STATUS_INVALID_VALUE;
+        }
+        zclPollControl_LongPollInterval = interval;
+        zclPollControl_AttributesChanged();
+        return ZSuccess;
+    }
+
+    case COMMAND_POLL_CONTROL_SET_SHORT_POLL_INTERVAL: {
+        if (pInMsg->pDataLen < 2) {
+            return ZCL_STATUS_MALFORMED_COMMAND;
+        }
+        uint16 interval = BUILD_UINT16(pData[0], pData[1]);
+        if (!zclPollControl_Valid(zclPollControl_CheckInInterval, zclPollControl_LongPollInterval, interval)) {
+            return ZCL_STATUS_INVALID_VALUE;
+        }
+        zclPollControl_ShortPollInterval = interval;
+        zclPollControl_AttributesChanged();
+        return ZSuccess;
+    }
+
+    default:
+        return ZFailure;
+    }
+}
+
+uint16 zclPollControl_event_loop(uint8 task_id, uint16 events) {
+    if (events & POLL_CONTROL_CHECKIN_EVT) {
+        zclPollControl_CheckIn();
+        zclPollControl_ScheduleCheckIn();
+        return (events ^ POLL_CONTROL_CHECKIN_EVT);
+    }
+    return 0;
+}
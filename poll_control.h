@@ -0,0 +1,93 @@
+#ifndef POLL_CONTROL_H
+#define POLL_CONTROL_H
+
+#include "hal_types.h"
+
+/*
+ * ZCL Poll Control cluster (0x0020) server.
+ * The device checks in every check-in interval; a coordinator with queued
+ * commands answers with a Check-in Response asking for a fast-poll burst,
+ * delivers them, and ends it with Fast Poll Stop. Intervals are in
+ * quarter-seconds as in the spec. Add the attribute globals below to the
+ * app attribute table (check-in interval writable).
+ */
+
+#ifndef ZCL_CLUSTER_ID_GEN_POLL_CONTROL
+    #define ZCL_CLUSTER_ID_GEN_POLL_CONTROL 0x0020
+#endif
+
+#ifndef ATTRID_POLL_CONTROL_CHECK_IN_INTERVAL
+    #define ATTRID_POLL_CONTROL_CHECK_IN_INTERVAL      0x0000
+    #define ATTRID_POLL_CONTROL_LONG_POLL_INTERVAL     0x0001
+    #define ATTRID_POLL_CONTROL_SHORT_POLL_INTERVAL    0x0002
+    #define ATTRID_POLL_CONTROL_FAST_POLL_TIMEOUT      0x0003
+    #define ATTRID_POLL_CONTROL_CHECK_IN_INTERVAL_MIN  0x0004
+    #define ATTRID_POLL_CONTROL_LONG_POLL_INTERVAL_MIN 0x0005
+    #define ATTRID_POLL_CONTROL_FAST_POLL_TIMEOUT_MAX  0x0006
+#endif
+
+// Server -> client
+#define COMMAND_POLL_CONTROL_CHECK_IN 0x00
+// Client -> server
+#define COMMAND_POLL_CONTROL_CHECK_IN_RSP 0x00
+#define COMMAND_POLL_CONTROL_FAST_POLL_STOP 0x01
+#define COMMAND_POLL_CONTROL_SET_LONG_POLL_INTERVAL 0x02
+#define COMMAND_POLL_CONTROL_SET_SHORT_POLL_INTERVAL 0x03
+
+#define POLL_CONTROL_CHECKIN_EVT 0x0001
+
+#define ZCD_NV_POLL_CONTROL 0x040C
+
+#ifndef POLL_CONTROL_ENDPOINT
+    #define POLL_CONTROL_ENDPOINT 1
+#endif
+
+// Defaults, quarter-seconds
+#ifndef POLL_CONTROL_DEFAULT_CHECK_IN_INTERVAL
+    #define POLL_CONTROL_DEFAULT_CHECK_IN_INTERVAL ((uint32)14400) // 1 hour
+#endif
+#ifndef POLL_CONTROL_DEFAULT_SHORT_POLL_INTERVAL
+    #define POLL_CONTROL_DEFAULT_SHORT_POLL_INTERVAL 2 // 500 ms
+#endif
+#ifndef POLL_CONTROL_DEFAULT_FAST_POLL_TIMEOUT
+    #define POLL_CONTROL_DEFAULT_FAST_POLL_TIMEOUT 40 // 10 s
+#endif
+#ifndef POLL_CONTROL_CHECK_IN_INTERVAL_MIN
+    #define POLL_CONTROL_CHECK_IN_INTERVAL_MIN ((uint32)240) // 1 minute
+#endif
+#ifndef POLL_CONTROL_LONG_POLL_INTERVAL_MIN
+    #define POLL_CONTROL_LONG_POLL_INTERVAL_MIN ((uint32)4) // 1 s
+#endif
+#ifndef POLL_CONTROL_FAST_POLL_TIMEOUT_MAX
+    #define POLL_CONTROL_FAST_POLL_TIMEOUT_MAX 480 // 2 minutes
+#endif
+
+// A check-in may run up to 1/N of its report slot (interval / REPORT_PHASE_SLOTS) late to share
+// a wakeup (wake_scheduler.h) - it never spills into the next device's slot
+#ifndef POLL_CONTROL_CHECK_IN_TOLERANCE_DIV
+    #define POLL_CONTROL_CHECK_IN_TOLERANCE_DIV 4
+#endif
+
+// Fast-poll after each check-in so the Check-in Response can be collected: the FastPollTimeout
+// attribute, clamped to these bounds, ms
+#ifndef POLL_CONTROL_CHECK_IN_RSP_WAIT_MIN
+    #define POLL_CONTROL_CHECK_IN_RSP_WAIT_MIN ((uint32)1000)
+#endif
+#ifndef POLL_CONTROL_CHECK_IN_RSP_WAIT_MAX
+    #define POLL_CONTROL_CHECK_IN_RSP_WAIT_MAX ((uint32)10000)
+#endif
+
+extern uint32 zclPollControl_CheckInInterval;
+extern uint32 zclPollControl_LongPollInterval;
+extern uint16 zclPollControl_ShortPollInterval;
+extern uint16 zclPollControl_FastPollTimeout;
+extern uint32 zclPollControl_CheckInIntervalMin;
+extern uint32 zclPollControl_LongPollIntervalMin;
+extern uint16 zclPollControl_FastPollTimeoutMax;
+
+extern void zclPollControl_Init(uint8 task_id);
+extern uint16 zclPollControl_event_loop(uint8 task_id, uint16 events);
+// Call after the coordinator wrote a Poll Control attribute - validates, applies and stores it
+extern void zclPollControl_AttributesChanged(void);
+
+#endif
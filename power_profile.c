@@ -0,0 +1,108 @@
+/*********************************************************************
+ * Battery-tiered power profiles
+ *
+ * NORMAL   - configured behaviour
+ * SAVER    - report/poll intervals x2, short LED pulses, 1 join flash,
+ *            interview capped at 30s, sensors one resolution step lower
+ * CRITICAL - intervals x4, minimal LED pulses, interview capped at 15s,
+ *            sensors at minimum resolution
+ *
+ * Modules query the current tier when they schedule work, so a change
+ * takes effect on the next cycle without extra timers.
+ *********************************************************************/
+
+#include "power_profile.h"
+#include "poll_arbiter.h"
+#include "Debug.h"
+#include "OSAL.h"
+#include "ZDApp.h"
+
+uint8 zclPowerProfile_Current = POWER_PROFILE_NORMAL;
+
+static uint8 zclPowerProfile_Evaluate(uint8 percentageZCL) {
+    switch (zclPowerProfile_Current) {
+    case POWER_PROFILE_CRITICAL:
+        if (percentageZCL < POWER_PROFILE_CRITICAL_THRESHOLD + POWER_PROFILE_HYSTERESIS) {
+            return POWER_PROFILE_CRITICAL;
+        }
+        break;
+    case POWER_PROFILE_SAVER:
+        if (percentageZCL < POWER_PROFILE_CRITICAL_THRESHOLD) {
+            return POWER_PROFILE_CRITICAL;
+        }
+        if (percentageZCL < POWER_PROFILE_SAVER_THRESHOLD + POWER_PROFILE_HYSTERESIS) {
+            return POWER_PROFILE_SAVER;
+        }
+        return POWER_PROFILE_NORMAL;
+    default:
+        break;
+    }
+
+    if (percentageZCL < POWER_PROFILE_CRITICAL_THRESHOLD) {
+        return POWER_PROFILE_CRITICAL;
+    }
+    if (percentageZCL < POWER_PROFILE_SAVER_THRESHOLD) {
+        return POWER_PROFILE_SAVER;
+    }
+    return POWER_PROFILE_NORMAL;
+}
+
+void zclPowerProfile_Update(uint8 percentageZCL) {
+    if (percentageZCL == 0xFF) {
+        return; // not sampled yet
+    }
+
+    uint8 profile = zclPowerProfile_Evaluate(percentageZCL);
+    if (profile == zclPowerProfile_Current) {
+        return;
+    }
+
+    LREP("Power profile %d -> %d (battery=%d)\r\n", zclPowerProfile_Current, profile, percentageZCL);
+    zclPowerProfile_Current = profile;
+
+    // Apply the new long-poll rate right away (the arbiter keeps any active fast-poll request)
+    if (devState == DEV_END_DEVICE) {
+        pollArbiter_Refresh();
+    }
+}
+
+uint32 zclPowerProfile_ScaleInterval(uint32 interval) {
+    uint8 shift = 0;
+    switch (zclPowerProfile_Current) {
+    case POWER_PROFILE_SAVER:
+        shift = 1;
+        break;
+    case POWER_PROFILE_CRITICAL:
+        shift = 2;
+        break;
+    default:
+        break;
+    }
+    // Saturate - a long check-in interval x4 would overflow, and timers compare as int32
+    if (interval > (POWER_PROFILE_MAX_INTERVAL >> shift)) {
+        return POWER_PROFILE_MAX_INTERVAL;
+    }
+    return interval << shift;
+}
+
+uint32 zclPowerProfile_CapInterview(uint32 period) {
+    switch (zclPowerProfile_Current) {
+    case POWER_PROFILE_SAVER:
+        return MIN(period, POWER_PROFILE_SAVER_INTERVIEW_CAP);
+    case POWER_PROFILE_CRITICAL:
+        return MIN(period, POWER_PROFILE_CRITICAL_INTERVIEW_CAP);
+    default:
+        return period;
+    }
+}
+
+uint8 zclPowerProfile_ResolutionDrop(void) {
+    switch (zclPowerProfile_Current) {
+    case POWER_PROFILE_SAVER:
+        return 1;
+    case POWER_PROFILE_CRITICAL:
+        return 3; // lowest resolution on every supported sensor
+    default:
+        return 0;
+    }
+}
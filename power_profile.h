@@ -0,0 +1,52 @@
+#ifndef POWER_PROFILE_H
+#define POWER_PROFILE_H
+
+#include "hal_types.h"
+
+// Custom POWER_CFG attribute: power profile currently in effect
+#define ATTRID_POWER_CFG_POWER_PROFILE                          0x0203
+
+#define POWER_PROFILE_NORMAL   0
+#define POWER_PROFILE_SAVER    1
+#define POWER_PROFILE_CRITICAL 2
+
+// Thresholds in ZCL BatteryPercentageRemaining units (0-200 = 0-100%)
+#ifndef POWER_PROFILE_SAVER_THRESHOLD
+    #define POWER_PROFILE_SAVER_THRESHOLD 40 // 20%
+#endif
+
+#ifndef POWER_PROFILE_CRITICAL_THRESHOLD
+    #define POWER_PROFILE_CRITICAL_THRESHOLD 16 // 8%
+#endif
+
+// A tier is only left once the percentage climbs this far above its threshold
+#ifndef POWER_PROFILE_HYSTERESIS
+    #define POWER_PROFILE_HYSTERESIS 4 // 2%
+#endif
+
+// Interview fast-poll window cap per tier
+#ifndef POWER_PROFILE_SAVER_INTERVIEW_CAP
+    #define POWER_PROFILE_SAVER_INTERVIEW_CAP ((uint32)30000)
+#endif
+
+#ifndef POWER_PROFILE_CRITICAL_INTERVIEW_CAP
+    #define POWER_PROFILE_CRITICAL_INTERVIEW_CAP ((uint32)15000)
+#endif
+
+// Upper bound of a scaled interval, ms
+#define POWER_PROFILE_MAX_INTERVAL ((uint32)0x7FFFFFFF)
+
+extern uint8 zclPowerProfile_Current;
+
+// Re-evaluate the tier from the latest battery percentage (called by battery.c)
+extern void zclPowerProfile_Update(uint8 percentageZCL);
+// Stretch a periodic interval for the current tier. The library scales its own timers - long poll,
+// Poll Control check-in, the periodic battery report and the diagnostics report intervals; apply
+// it to the app's sensor cadence too (before reportPhase_NextDelay)
+extern uint32 zclPowerProfile_ScaleInterval(uint32 interval);
+// Cap the post-join interview fast-poll window for the current tier
+extern uint32 zclPowerProfile_CapInterview(uint32 period);
+// Number of resolution steps sensors should drop below their configured resolution
+extern uint8 zclPowerProfile_ResolutionDrop(void);
+
+#endif
@@ -0,0 +1,127 @@
+#include "report_frame.h"
+#include "Debug.h"
+#include "OSAL.h"
+#include "AF.h"
+#include "bdb_interface.h"
+
+#define REPORT_FRAME_NO_CLUSTER 0xFFFF
+
+typedef struct {
+    uint8 endpoint; // 0 = unused
+    zclOptionRec_t options[REPORT_FRAME_CLASS_CLUSTERS];
+} ReportFrameOptionList_t;
+
+// ZCL keeps a pointer to each list and reads the option on every send, so editing a
+// record in place switches the APS options of the next frame for that cluster
+static ReportFrameOptionList_t zclReportFrame_OptionLists[REPORT_FRAME_CLASS_ENDPOINTS];
+static uint32 zclReportFrame_LastAcked = 0;
+static bool zclReportFrame_AckPending = false;  // an ACKED send is awaiting its confirm
+static uint8 zclReportFrame_AckFailures = 0;    // ACKED sends failed in a row
+
+// Reports go to whatever the coordinator bound (AddrNotPresent = binding table lookup)
+static afAddrType_t zclReportFrame_IndirectDstAddr = {.addrMode = (afAddrMode_t)AddrNotPresent, .endPoint = 0, .addr.shortAddr = 0};
+
+zclReportCmd_t *zclReportFrame_Build(uint8 *storage, const zclReport_t *bindings, uint8 numAttr) {
+    zclReportCmd_t *frame = (zclReportCmd_t *)storage;
+    frame->numAttr = numAttr;
+    osal_memcpy(frame->attrList, bindings, numAttr * sizeof(zclReport_t));
+    return frame;
+}
+
+static zclOptionRec_t *zclReportFrame_OptionRec(uint8 endpoint, uint16 clusterId) {
+    ReportFrameOptionList_t *list = NULL;
+    for (uint8 i = 0; i < REPORT_FRAME_CLASS_ENDPOINTS; i++) {
+        if (zclReportFrame_OptionLists[i].endpoint == endpoint) {
+            list = &zclReportFrame_OptionLists[i];
+            break;
+        }
+        if (list == NULL && zclReportFrame_OptionLists[i].endpoint == 0) {
+            list = &zclReportFrame_OptionLists[i];
+        }
+    }
+    if (list == NULL) {
+        return NULL;
+    }
+    if (list->endpoint == 0) {
+        for (uint8 i = 0; i < REPORT_FRAME_CLASS_CLUSTERS; i++) {
+            list->options[i].clusterID = REPORT_FRAME_NO_CLUSTER;
+            list->options[i].option = AF_TX_OPTIONS_NONE;
+        }
+        if (zcl_registerClusterOptionList(endpoint, REPORT_FRAME_CLASS_CLUSTERS, list->options) != ZSuccess) {
+            return NULL;
+        }
+        list->endpoint = endpoint;
+    }
+
+    zclOptionRec_t *unused = NULL;
+    for (uint8 i = 0; i < REPORT_FRAME_CLASS_CLUSTERS; i++) {
+        if (list->options[i].clusterID == clusterId) {
+            return &list->options[i];
+        }
+        if (unused == NULL && list->options[i].clusterID == REPORT_FRAME_NO_CLUSTER) {
+            unused = &list->options[i];
+        }
+    }
+    if (unused != NULL) {
+        unused->clusterID = clusterId;
+    }
+    return unused;
+}
+
+// Probe interval after the current run of failures
+static uint32 zclReportFrame_ProbeInterval(void) {
+    uint32 interval = REPORT_FRAME_PROBE_INTERVAL >> MIN(zclReportFrame_AckFailures, 16);
+    return MAX(interval, REPORT_FRAME_PROBE_MIN_INTERVAL);
+}
+
+uint8 zclReportFrame_ApplyClass(uint8 endpoint, uint16 clusterId, uint8 reliability) {
+    uint32 now = osal_GetSystemClock();
+    if (REPORT_FRAME_PROBE_INTERVAL != 0 && reliability == ZCL_REPORT_CLASS_FIRE_AND_FORGET &&
+        now - zclReportFrame_LastAcked >= zclReportFrame_ProbeInterval()) {
+        LREP("Report 0x%X promoted to link probe\r\n", clusterId);
+        reliability = ZCL_REPORT_CLASS_ACKED;
+    }
+    zclOptionRec_t *rec = zclReportFrame_OptionRec(endpoint, clusterId);
+    if (rec == NULL) {
+        return ZCL_REPORT_CLASS_FIRE_AND_FORGET; // no room - ZCL default options apply
+    }
+    rec->option = (reliability == ZCL_REPORT_CLASS_ACKED) ? AF_ACK_REQUEST : AF_TX_OPTIONS_NONE;
+    if (reliability == ZCL_REPORT_CLASS_ACKED) {
+        zclReportFrame_LastAcked = now;
+        zclReportFrame_AckPending = true;
+    }
+    return reliability;
+}
+
+uint8 zclReportFrame_OnConfirm(uint8 status) {
+    if (status == ZApsNoAck) {
+        if (zclReportFrame_AckFailures < 0xFF) {
+            zclReportFrame_AckFailures++;
+        }
+        LREP("ACKED send failed (%d in a row), next probe in %ld ms\r\n", zclReportFrame_AckFailures,
+             zclReportFrame_ProbeInterval());
+    } else if (status == ZSuccess && zclReportFrame_AckPending) {
+        // Confirms can't be matched to sends; a success while an ACKED send is out is taken as its ACK
+        zclReportFrame_AckFailures = 0;
+    }
+    zclReportFrame_AckPending = false;
+    return zclReportFrame_AckFailures;
+}
+
+void zclReportFrame_ResetProbe(void) {
+    zclReportFrame_AckFailures = 0;
+    zclReportFrame_AckPending = false;
+}
+
+ZStatus_t zclReportFrame_SendClass(uint8 endpoint, uint16 clusterId, zclReportCmd_t *frame, uint8 reliability) {
+    zclReportFrame_ApplyClass(endpoint, clusterId, reliability);
+    return zclReportFrame_Send(endpoint, clusterId, frame);
+}
+
+ZStatus_t zclReportFrame_Send(uint8 endpoint, uint16 clusterId, zclReportCmd_t *frame) {
+    if (frame == NULL || frame->numAttr == 0) {
+        return ZInvalidParameter;
+    }
+    return zcl_SendReportCmd(endpoint, &zclReportFrame_IndirectDstAddr, clusterId, frame, ZCL_FRAME_SERVER_CLIENT_DIR, TRUE,
+                             bdb_getZCLFrameCounter());
+}
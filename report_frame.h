@@ -0,0 +1,55 @@
+#ifndef REPORT_FRAME_H
+#define REPORT_FRAME_H
+
+#include "zcl.h"
+
+/*
+ * Preallocated ZCL report frames. Each report path declares its storage
+ * statically, binds attribute pointers to its globals once at init and
+ * sends the same frame every time - no OSAL heap traffic on the report path.
+ */
+
+#define ZCL_REPORT_FRAME_SIZE(numAttr) (sizeof(zclReportCmd_t) + (numAttr) * sizeof(zclReport_t))
+
+// Reliability classes, applied per send through a mutable ZCL cluster option list
+#define ZCL_REPORT_CLASS_FIRE_AND_FORGET 0 // superseded by the next report - no APS ACK wait or retries
+#define ZCL_REPORT_CLASS_ACKED 1           // state changes, alarms, anything not repeated - APS ACK + retries
+
+// Endpoints and clusters the option lists can cover. The lists are registered with
+// zcl_registerClusterOptionList on first use - don't register another list on those endpoints.
+#ifndef REPORT_FRAME_CLASS_ENDPOINTS
+    #define REPORT_FRAME_CLASS_ENDPOINTS 1
+#endif
+#ifndef REPORT_FRAME_CLASS_CLUSTERS
+    #define REPORT_FRAME_CLASS_CLUSTERS 4
+#endif
+
+// Link probe: a fire-and-forget send is promoted to ACKED when nothing acknowledged went out
+// for this long, so a silently broken path shows up as a failed AF_DATA_CONFIRM (counted in
+// network_metrics.aps_ack_failures). Each failed ACKED send in a row halves the interval, down
+// to the minimum, so a dead path is confirmed quickly. 0 = never.
+#ifndef REPORT_FRAME_PROBE_INTERVAL
+    #define REPORT_FRAME_PROBE_INTERVAL ((uint32)3600000) // 1 hour
+#endif
+#ifndef REPORT_FRAME_PROBE_MIN_INTERVAL
+    #define REPORT_FRAME_PROBE_MIN_INTERVAL ((uint32)60000) // 1 minute
+#endif
+
+// Declare static storage for a frame carrying numAttr attributes
+#define ZCL_REPORT_FRAME_DECLARE(name, numAttr) static uint8 name[ZCL_REPORT_FRAME_SIZE(numAttr)]
+
+// Build the frame in storage from a binding table (attrID, dataType, pointer to global)
+extern zclReportCmd_t *zclReportFrame_Build(uint8 *storage, const zclReport_t *bindings, uint8 numAttr);
+// Send a built frame to the bound destinations (indirect, server->client)
+extern ZStatus_t zclReportFrame_Send(uint8 endpoint, uint16 clusterId, zclReportCmd_t *frame);
+// Same, with a reliability class (ZCL_REPORT_CLASS_*)
+extern ZStatus_t zclReportFrame_SendClass(uint8 endpoint, uint16 clusterId, zclReportCmd_t *frame, uint8 reliability);
+// Set the class for the next frame from endpoint/cluster (for commands sent with zcl_SendCommand).
+// Returns the class actually applied - ACKED when a fire-and-forget send became the link probe.
+extern uint8 zclReportFrame_ApplyClass(uint8 endpoint, uint16 clusterId, uint8 reliability);
+// Status of every AF_DATA_CONFIRM_CMD (zclCommissioning_OnTxConfirm forwards it). Returns the
+// ACKED sends that failed in a row - commissioning acts on it, see APP_COMMISSIONING_PROBE_FAILURES.
+extern uint8 zclReportFrame_OnConfirm(uint8 status);
+extern void zclReportFrame_ResetProbe(void);
+
+#endif
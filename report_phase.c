@@ -0,0 +1,59 @@
+/*********************************************************************
+ * Reporting phase scheduler
+ *
+ * Devices that power up together (a site after an outage, a batch out of
+ * the box) run the same ZCL_BATTERY_REPORT_INTERVAL and sensor cadence
+ * from the same moment, so they report in bursts and pay for it in MAC
+ * retries and APS retransmissions. Each periodic job is instead re-armed
+ * to the start of this device's slot: the interval is split into
+ * REPORT_PHASE_SLOTS and the slot comes from an FNV-1a hash of the IEEE
+ * address, which is stable per device and uniform across a site. With
+ * REPORT_PHASE_USE_UTC the slots are anchored to the Time cluster clock
+ * once it is set, so they survive reboots and are the same slots on
+ * every device; until then they count from boot.
+ *********************************************************************/
+
+#include "report_phase.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "ZDApp.h"
+
+static uint8 reportPhase_SlotCache = 0xFF;
+
+uint8 reportPhase_Slot(void) {
+    if (reportPhase_SlotCache == 0xFF) {
+        uint8 *ieee = NLME_GetExtAddr();
+        uint32 hash = 2166136261; // FNV-1a offset basis
+        if (ieee != NULL) {
+            for (uint8 i = 0; i < Z_EXTADDR_LEN; i++) {
+                hash = (hash ^ ieee[i]) * 16777619;
+            }
+        }
+        // Fold so every address byte reaches the low bits
+        reportPhase_SlotCache = (uint8)((hash ^ (hash >> 16)) % REPORT_PHASE_SLOTS);
+    }
+    return reportPhase_SlotCache;
+}
+
+uint32 reportPhase_NextDelay(uint32 interval) {
+    uint32 period = interval;
+    uint32 pos;
+
+#if defined(REPORT_PHASE_USE_UTC)
+    uint32 utc = osal_getClock();
+    if (utc >= REPORT_PHASE_UTC_VALID_MIN && interval >= 1000) {
+        period = (interval / 1000) * 1000; // UTC has second resolution
+        pos = (utc % (interval / 1000)) * 1000;
+    } else
+#endif
+    {
+        if (period == 0) {
+            return 0;
+        }
+        pos = osal_GetSystemClock() % period;
+    }
+
+    uint32 offset = (uint32)reportPhase_Slot() * (period / REPORT_PHASE_SLOTS);
+    uint32 delay = (offset + period - pos) % period;
+    return delay ? delay : period;
+}
@@ -0,0 +1,32 @@
+#ifndef REPORT_PHASE_H
+#define REPORT_PHASE_H
+
+#include "hal_types.h"
+
+/*
+ * Reporting phase scheduler: every periodic job runs in this device's own
+ * slot of its interval, picked from a hash of the IEEE address, so devices
+ * with the same cadence spread their airtime evenly instead of reporting
+ * together. Use reportPhase_NextDelay() in place of the plain interval
+ * when re-arming a periodic timer - the phase never drifts.
+ */
+
+// Slots per interval - more slots, fewer devices sharing one
+#ifndef REPORT_PHASE_SLOTS
+    #define REPORT_PHASE_SLOTS 64
+#endif
+
+// Align slots to the UTC clock (osal_getClock, set from the Time cluster) once it is valid,
+// so they stay put across reboots and line up between devices. Otherwise slots count from boot.
+// #define REPORT_PHASE_USE_UTC
+// osal_getClock() values below this are uptime, not UTC (2021-01-01, seconds since 2000)
+#ifndef REPORT_PHASE_UTC_VALID_MIN
+    #define REPORT_PHASE_UTC_VALID_MIN ((uint32)662774400)
+#endif
+
+// This device's slot, 0 .. REPORT_PHASE_SLOTS - 1
+extern uint8 reportPhase_Slot(void);
+// ms until this device's next slot start in a period of interval ms (interval itself when exactly on the slot)
+extern uint32 reportPhase_NextDelay(uint32 interval);
+
+#endif
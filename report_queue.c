@@ -0,0 +1,260 @@
+/*********************************************************************
+ * Offline report queue
+ *
+ * A reading taken while the parent is lost used to be reported into the
+ * void (or not at all) and the coordinator simply saw a gap. Readings
+ * are now kept with their osal_getClock() timestamp in a small RAM queue
+ * and, when REPORT_QUEUE_NV_SPILL is set, written to an NV block in one
+ * write whenever the RAM queue fills. After the rejoin everything is sent
+ * back-to-back as telemetry history frames while the post-join fast-poll
+ * window is still open, so the radio stays on once instead of waking for
+ * each reading. Readings are dropped only once the stack took their frame;
+ * the rest waits for the next flush.
+ * Ages of readings spilled before a reboot are only meaningful once the
+ * clock has been set from the Time cluster.
+ *********************************************************************/
+
+#include "report_queue.h"
+#include "telemetry.h"
+#include "report_frame.h"
+#include "Debug.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_Nv.h"
+#include "ZDApp.h"
+#include "zcl.h"
+#include "bdb_interface.h"
+
+#define REPORT_QUEUE_ENTRY_LEN 7
+#define REPORT_QUEUE_AGE_UNKNOWN 0xFFFFFFFF
+#define REPORT_QUEUE_RAM 0xFF // block index meaning the RAM queue
+
+typedef struct {
+    uint32 timestamp; // osal_getClock(), seconds
+    int16 value;
+    uint8 slot;
+} ReportQueueEntry_t;
+
+typedef struct {
+    uint8 seq;   // spill order, wraps (NV only)
+    uint8 start; // first entry not sent yet - start == count: block empty
+    uint8 count; // entries stored
+} ReportQueueBlockHeader_t;
+
+// The RAM queue has the NV block layout, so a spill is one NV write of the whole queue
+typedef struct {
+    ReportQueueBlockHeader_t hdr;
+    ReportQueueEntry_t entries[REPORT_QUEUE_CAPACITY];
+} ReportQueueBlock_t;
+
+static ReportQueueBlock_t reportQueue_Ram; // oldest first, hdr.start stays 0
+
+static uint8 reportQueue_Frame[2 + REPORT_QUEUE_FRAME_ENTRIES * REPORT_QUEUE_ENTRY_LEN];
+static uint8 reportQueue_FrameEntries = 0;
+static afAddrType_t reportQueue_DstAddr = {.addrMode = (afAddrMode_t)AddrNotPresent, .endPoint = 0, .addr.shortAddr = 0};
+
+// Drop the n oldest RAM entries
+static void reportQueue_DropRam(uint8 n) {
+    uint8 left = reportQueue_Ram.hdr.count - n;
+    for (uint8 i = 0; i < left; i++) {
+        reportQueue_Ram.entries[i] = reportQueue_Ram.entries[i + n];
+    }
+    reportQueue_Ram.hdr.count = left;
+}
+
+#if defined(REPORT_QUEUE_NV_SPILL)
+#define REPORT_QUEUE_NV_LEN ((uint16)REPORT_QUEUE_NV_BLOCKS * sizeof(ReportQueueBlock_t))
+#define REPORT_QUEUE_BLOCK_OFFSET(b) ((uint16)(b) * sizeof(ReportQueueBlock_t))
+#define REPORT_QUEUE_ENTRY_OFFSET(b, i)                                                                                          \
+    (REPORT_QUEUE_BLOCK_OFFSET(b) + sizeof(ReportQueueBlockHeader_t) + (uint16)(i) * sizeof(ReportQueueEntry_t))
+
+static bool reportQueue_NvReady(void) {
+    uint16 stored = osal_nv_item_len(ZCD_NV_REPORT_QUEUE);
+    if (stored != 0 && stored != REPORT_QUEUE_NV_LEN) {
+        osal_nv_delete(ZCD_NV_REPORT_QUEUE, stored); // older layout or another block count - start over
+    }
+    uint8 status = osal_nv_item_init(ZCD_NV_REPORT_QUEUE, REPORT_QUEUE_NV_LEN, NULL);
+    if (status == NV_ITEM_UNINIT) {
+        // New item - mark every block empty (once)
+        ReportQueueBlockHeader_t hdr = {0, 0, 0};
+        for (uint8 b = 0; b < REPORT_QUEUE_NV_BLOCKS; b++) {
+            if (osal_nv_write(ZCD_NV_REPORT_QUEUE, REPORT_QUEUE_BLOCK_OFFSET(b), sizeof(hdr), &hdr) != SUCCESS) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return status == SUCCESS;
+}
+
+/*
+ * Walk the block headers. oldest: pending block with the oldest sequence
+ * number (REPORT_QUEUE_RAM if none); target: block for the next spill - a
+ * free one, else the oldest; seq: sequence number for that spill.
+ * Returns the number of entries pending in NV.
+ */
+static uint8 reportQueue_NvScan(uint8 *oldest, uint8 *target, uint8 *seq) {
+    ReportQueueBlockHeader_t hdr;
+    uint8 pending = 0;
+    uint8 oldestSeq = 0;
+    uint8 newestSeq = 0;
+    *oldest = REPORT_QUEUE_RAM;
+    *target = REPORT_QUEUE_RAM;
+    for (uint8 b = 0; b < REPORT_QUEUE_NV_BLOCKS; b++) {
+        if (osal_nv_read(ZCD_NV_REPORT_QUEUE, REPORT_QUEUE_BLOCK_OFFSET(b), sizeof(hdr), &hdr) != SUCCESS ||
+            hdr.count > REPORT_QUEUE_CAPACITY || hdr.start >= hdr.count) {
+            if (*target == REPORT_QUEUE_RAM) {
+                *target = b;
+            }
+            continue;
+        }
+        if (pending == 0 || (int8)(hdr.seq - newestSeq) > 0) {
+            newestSeq = hdr.seq;
+        }
+        if (pending == 0 || (int8)(hdr.seq - oldestSeq) < 0) {
+            oldestSeq = hdr.seq;
+            *oldest = b;
+        }
+        pending += hdr.count - hdr.start;
+    }
+    *seq = (pending != 0) ? (uint8)(newestSeq + 1) : 0;
+    if (*target == REPORT_QUEUE_RAM) {
+        *target = *oldest; // all blocks pending - overwrite the oldest
+    }
+    return pending;
+}
+
+// Move the whole RAM queue to NV in one write, overwriting the oldest block when NV is full
+static void reportQueue_Spill(void) {
+    uint8 oldest, target, seq;
+    if (!reportQueue_NvReady()) {
+        return;
+    }
+    reportQueue_NvScan(&oldest, &target, &seq);
+    reportQueue_Ram.hdr.seq = seq;
+    if (osal_nv_write(ZCD_NV_REPORT_QUEUE, REPORT_QUEUE_BLOCK_OFFSET(target), sizeof(ReportQueueBlock_t), &reportQueue_Ram) !=
+        SUCCESS) {
+        return;
+    }
+    LREP("Report queue: spilled %d to block %d\r\n", reportQueue_Ram.hdr.count, target);
+    reportQueue_Ram.hdr.count = 0;
+}
+#endif
+
+bool reportQueue_Push(uint8 slot, int16 value) {
+    if (devState == DEV_END_DEVICE) {
+        return false;
+    }
+#if defined(REPORT_QUEUE_NV_SPILL)
+    if (reportQueue_Ram.hdr.count == REPORT_QUEUE_CAPACITY) {
+        reportQueue_Spill();
+    }
+#endif
+    if (reportQueue_Ram.hdr.count == REPORT_QUEUE_CAPACITY) {
+        reportQueue_DropRam(1); // no room (or NV failed) - drop the oldest
+    }
+    ReportQueueEntry_t *entry = &reportQueue_Ram.entries[reportQueue_Ram.hdr.count++];
+    entry->timestamp = osal_getClock();
+    entry->value = value;
+    entry->slot = slot;
+    return true;
+}
+
+uint8 reportQueue_Count(void) {
+    uint8 count = reportQueue_Ram.hdr.count;
+#if defined(REPORT_QUEUE_NV_SPILL)
+    uint8 oldest, target, seq;
+    if (reportQueue_NvReady()) {
+        count += reportQueue_NvScan(&oldest, &target, &seq);
+    }
+#endif
+    return count;
+}
+
+static ZStatus_t reportQueue_SendFrame(void) {
+    reportQueue_Frame[0] = ZCL_TELEMETRY_VERSION;
+    reportQueue_Frame[1] = reportQueue_FrameEntries;
+    uint8 len = 2 + reportQueue_FrameEntries * REPORT_QUEUE_ENTRY_LEN;
+    LREP("Report queue: history frame entries=%d\r\n", reportQueue_FrameEntries);
+    reportQueue_FrameEntries = 0;
+    // History is not repeated by a later frame - ask for the APS ACK
+    zclReportFrame_ApplyClass(ZCL_TELEMETRY_ENDPOINT, ZCL_CLUSTER_ID_TELEMETRY, ZCL_REPORT_CLASS_ACKED);
+    return zcl_SendCommand(ZCL_TELEMETRY_ENDPOINT, &reportQueue_DstAddr, ZCL_CLUSTER_ID_TELEMETRY, ZCL_TELEMETRY_CMD_HISTORY,
+                           TRUE, ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, ZCL_TELEMETRY_MANUFACTURER_CODE, bdb_getZCLFrameCounter(),
+                           len, reportQueue_Frame);
+}
+
+static void reportQueue_Append(const ReportQueueEntry_t *entry, uint32 now) {
+    uint32 age = (entry->timestamp <= now) ? (now - entry->timestamp) : REPORT_QUEUE_AGE_UNKNOWN;
+    uint8 *p = &reportQueue_Frame[2 + reportQueue_FrameEntries * REPORT_QUEUE_ENTRY_LEN];
+    *p++ = entry->slot;
+    *p++ = LO_UINT16((uint16)entry->value);
+    *p++ = HI_UINT16((uint16)entry->value);
+    *p++ = BREAK_UINT32(age, 0);
+    *p++ = BREAK_UINT32(age, 1);
+    *p++ = BREAK_UINT32(age, 2);
+    *p++ = BREAK_UINT32(age, 3);
+    reportQueue_FrameEntries++;
+}
+
+/*
+ * Send entries [start, count) of a block - the RAM queue or an NV block -
+ * as history frames. Stops at the first frame the stack refuses and
+ * returns the index of the first entry not handed over, so only what went
+ * out is ever dropped.
+ */
+static uint8 reportQueue_SendEntries(uint8 block, uint8 start, uint8 count, uint32 now) {
+    ReportQueueEntry_t entry;
+    uint8 sent = start;
+    reportQueue_FrameEntries = 0;
+    for (uint8 i = start; i < count; i++) {
+        if (block == REPORT_QUEUE_RAM) {
+            entry = reportQueue_Ram.entries[i];
+        }
+#if defined(REPORT_QUEUE_NV_SPILL)
+        else if (osal_nv_read(ZCD_NV_REPORT_QUEUE, REPORT_QUEUE_ENTRY_OFFSET(block, i), sizeof(entry), &entry) != SUCCESS) {
+            break;
+        }
+#endif
+        reportQueue_Append(&entry, now);
+        if (reportQueue_FrameEntries == REPORT_QUEUE_FRAME_ENTRIES || i + 1 == count) {
+            if (reportQueue_SendFrame() != ZSuccess) {
+                break;
+            }
+            sent = i + 1;
+        }
+    }
+    reportQueue_FrameEntries = 0;
+    return sent;
+}
+
+void reportQueue_Flush(void) {
+    if (devState != DEV_END_DEVICE) {
+        return;
+    }
+    uint32 now = osal_getClock();
+
+#if defined(REPORT_QUEUE_NV_SPILL)
+    // NV holds the older readings - send them first, oldest block first
+    uint8 block, target, seq;
+    if (reportQueue_NvReady()) {
+        while (reportQueue_NvScan(&block, &target, &seq) > 0) {
+            ReportQueueBlockHeader_t hdr;
+            if (osal_nv_read(ZCD_NV_REPORT_QUEUE, REPORT_QUEUE_BLOCK_OFFSET(block), sizeof(hdr), &hdr) != SUCCESS) {
+                return;
+            }
+            uint8 sent = reportQueue_SendEntries(block, hdr.start, hdr.count, now);
+            if (sent == hdr.start) {
+                return; // nothing went out - keep it all, and the newer RAM readings behind it
+            }
+            hdr.start = sent;
+            if (osal_nv_write(ZCD_NV_REPORT_QUEUE, REPORT_QUEUE_BLOCK_OFFSET(block), sizeof(hdr), &hdr) != SUCCESS ||
+                sent < hdr.count) {
+                return;
+            }
+        }
+    }
+#endif
+
+    reportQueue_DropRam(reportQueue_SendEntries(REPORT_QUEUE_RAM, 0, reportQueue_Ram.hdr.count, now));
+}
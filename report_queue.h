@@ -0,0 +1,45 @@
+#ifndef REPORT_QUEUE_H
+#define REPORT_QUEUE_H
+
+#include "hal_types.h"
+
+/*
+ * Offline report queue: readings taken while the device has no parent are
+ * kept with a timestamp instead of being lost, and sent back-to-back as
+ * telemetry history frames (ZCL_TELEMETRY_CMD_HISTORY) right after the
+ * join or rejoin.
+ */
+
+#ifndef REPORT_QUEUE_CAPACITY
+    #define REPORT_QUEUE_CAPACITY 8
+#endif
+
+// Optional NV spill: a full RAM queue is written to one of REPORT_QUEUE_NV_BLOCKS NV blocks in a
+// single write (the oldest block is overwritten when all hold readings), so longer outages and
+// reboots keep their readings. REPORT_QUEUE_NV_BLOCKS * REPORT_QUEUE_CAPACITY must stay below 256.
+// #define REPORT_QUEUE_NV_SPILL
+#ifndef REPORT_QUEUE_NV_BLOCKS
+    #define REPORT_QUEUE_NV_BLOCKS 4
+#endif
+#define ZCD_NV_REPORT_QUEUE 0x040D
+
+// Entries per history frame (7 bytes each)
+#ifndef REPORT_QUEUE_FRAME_ENTRIES
+    #define REPORT_QUEUE_FRAME_ENTRIES 10
+#endif
+
+// Slots for the library's own readings - app sensor slots stay below ZCL_TELEMETRY_MAX_SENSORS
+#define REPORT_QUEUE_SLOT_BATTERY_MV      0xF0 // loaded voltage if sampled, else idle
+#define REPORT_QUEUE_SLOT_BATTERY_PERCENT 0xF1 // ZCL units (0-200)
+
+// Queue a reading (slot as in zclTelemetry_SetSensor) if offline. zclTelemetry_SetSensor and
+// zclBattery_Report already call it. Returns TRUE if queued,
+// FALSE if the device is connected and the caller should report as usual.
+extern bool reportQueue_Push(uint8 slot, int16 value);
+// Send everything queued as history frames. Commissioning calls it after every join and rejoin,
+// and again a few times (APP_COMMISSIONING_QUEUE_RETRIES) while entries remain. Entries whose
+// frame the stack refused stay queued for the next call.
+extern void reportQueue_Flush(void);
+extern uint8 reportQueue_Count(void);
+
+#endif
@@ -0,0 +1,72 @@
+#include "telemetry.h"
+#include "battery.h"
+#include "commissioning.h"
+#include "power_profile.h"
+#include "report_frame.h"
+#include "report_queue.h"
+#include "Debug.h"
+#include "OSAL.h"
+#include "zcl.h"
+#include "bdb_interface.h"
+
+#define ZCL_TELEMETRY_HEADER_LEN 13
+#define ZCL_TELEMETRY_MAX_LEN (ZCL_TELEMETRY_HEADER_LEN + 2 * ZCL_TELEMETRY_MAX_SENSORS)
+
+// Filled with ZCL_TELEMETRY_SENSOR_INVALID on the first SetSensor - only slots below SensorCount are sent
+static int16 zclTelemetry_Sensors[ZCL_TELEMETRY_MAX_SENSORS];
+static uint8 zclTelemetry_SensorCount = 0;
+
+static uint8 zclTelemetry_Frame[ZCL_TELEMETRY_MAX_LEN];
+static afAddrType_t zclTelemetry_DstAddr = {.addrMode = (afAddrMode_t)AddrNotPresent, .endPoint = 0, .addr.shortAddr = 0};
+
+void zclTelemetry_SetSensor(uint8 slot, int16 value) {
+    if (slot >= ZCL_TELEMETRY_MAX_SENSORS) {
+        return;
+    }
+    if (zclTelemetry_SensorCount == 0) {
+        for (uint8 i = 0; i < ZCL_TELEMETRY_MAX_SENSORS; i++) {
+            zclTelemetry_Sensors[i] = ZCL_TELEMETRY_SENSOR_INVALID;
+        }
+    }
+    zclTelemetry_Sensors[slot] = value;
+    if (slot >= zclTelemetry_SensorCount) {
+        zclTelemetry_SensorCount = slot + 1;
+    }
+    reportQueue_Push(slot, value); // no-op while connected
+}
+
+static uint8 *zclTelemetry_PutUint16(uint8 *p, uint16 value) {
+    *p++ = LO_UINT16(value);
+    *p++ = HI_UINT16(value);
+    return p;
+}
+
+static uint8 zclTelemetry_Build(void) {
+    uint8 *p = zclTelemetry_Frame;
+    uint16 millivolts = zclBattery_LoadedMillivolts ? zclBattery_LoadedMillivolts : zclBattery_IdleMillivolts;
+
+    *p++ = ZCL_TELEMETRY_VERSION;
+    p = zclTelemetry_PutUint16(p, millivolts);
+    *p++ = zclBattery_PercentageRemainig;
+    *p++ = zclPowerProfile_Current;
+    *p++ = network_metrics.parent_lqi;
+    *p++ = (uint8)network_metrics.current_tx_power;
+    *p++ = network_metrics.last_channel;
+    p = zclTelemetry_PutUint16(p, network_metrics.rejoin_failures);
+    p = zclTelemetry_PutUint16(p, network_metrics.consecutive_failures);
+    *p++ = zclTelemetry_SensorCount;
+    for (uint8 i = 0; i < zclTelemetry_SensorCount; i++) {
+        p = zclTelemetry_PutUint16(p, (uint16)zclTelemetry_Sensors[i]);
+    }
+    return (uint8)(p - zclTelemetry_Frame);
+}
+
+ZStatus_t zclTelemetry_Send(void) {
+    uint8 len = zclTelemetry_Build();
+    LREP("Telemetry frame len=%d sensors=%d\r\n", len, zclTelemetry_SensorCount);
+    // Each frame carries the full current state, so a lost one is replaced by the next
+    zclReportFrame_ApplyClass(ZCL_TELEMETRY_ENDPOINT, ZCL_CLUSTER_ID_TELEMETRY, ZCL_REPORT_CLASS_FIRE_AND_FORGET);
+    return zcl_SendCommand(ZCL_TELEMETRY_ENDPOINT, &zclTelemetry_DstAddr, ZCL_CLUSTER_ID_TELEMETRY, ZCL_TELEMETRY_CMD_REPORT, TRUE,
+                           ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, ZCL_TELEMETRY_MANUFACTURER_CODE, bdb_getZCLFrameCounter(), len,
+                           zclTelemetry_Frame);
+}
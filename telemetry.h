@@ -0,0 +1,63 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "hal_types.h"
+#include "ZComDef.h"
+
+/*
+ * Optional manufacturer-specific telemetry cluster: one frame per wake
+ * carrying battery, sensor and network highlights instead of one report
+ * (and one APS ACK) per cluster. Standard clusters stay untouched so
+ * generic coordinators keep working; bind this cluster to opt in.
+ *
+ * ZCL_TELEMETRY_CMD_REPORT payload (server -> client, little-endian):
+ *   uint8  version          ZCL_TELEMETRY_VERSION
+ *   uint16 battery_mv       loaded voltage if sampled, else idle
+ *   uint8  battery_percent  ZCL units (0-200)
+ *   uint8  power_profile    see power_profile.h
+ *   uint8  parent_lqi
+ *   int8   tx_power         dBm
+ *   uint8  channel
+ *   uint16 rejoin_failures
+ *   uint16 consecutive_failures
+ *   uint8  sensor_count     N
+ *   int16  sensor[N]        app-defined slots, ZCL_TELEMETRY_SENSOR_INVALID if unset
+ *
+ * ZCL_TELEMETRY_CMD_HISTORY payload (server -> client, little-endian) -
+ * readings queued while the device was offline, see report_queue.h:
+ *   uint8  version          ZCL_TELEMETRY_VERSION
+ *   uint8  count            N
+ *   N x { uint8 slot, int16 value, uint32 age_s }   age at send time, 0xFFFFFFFF if unknown
+ *   slot is a sensor slot or REPORT_QUEUE_SLOT_BATTERY_* for battery readings
+ */
+
+#ifndef ZCL_CLUSTER_ID_TELEMETRY
+    #define ZCL_CLUSTER_ID_TELEMETRY 0xFC57
+#endif
+
+// 0 = frames are not marked manufacturer-specific
+#ifndef ZCL_TELEMETRY_MANUFACTURER_CODE
+    #define ZCL_TELEMETRY_MANUFACTURER_CODE 0x0000
+#endif
+
+#ifndef ZCL_TELEMETRY_ENDPOINT
+    #define ZCL_TELEMETRY_ENDPOINT 1
+#endif
+
+#ifndef ZCL_TELEMETRY_MAX_SENSORS
+    #define ZCL_TELEMETRY_MAX_SENSORS 4
+#endif
+
+#define ZCL_TELEMETRY_CMD_REPORT 0x00
+#define ZCL_TELEMETRY_CMD_HISTORY 0x01
+
+#define ZCL_TELEMETRY_VERSION 1
+#define ZCL_TELEMETRY_SENSOR_INVALID ((int16)0x8000)
+
+// Store the latest value of an app sensor (e.g. temperature in centidegrees, CO2 ppm); while
+// offline it is also queued for the history frames sent after the rejoin
+extern void zclTelemetry_SetSensor(uint8 slot, int16 value);
+// Build and send the compact frame to bound destinations
+extern ZStatus_t zclTelemetry_Send(void);
+
+#endif
@@ -1,9 +1,19 @@
 #include "utils.h"
 #include "hal_adc.h"
+#include "hal_mcu.h"
 
 // #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 // #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
+// CC2530 ADC registers (see hal_adc.c)
+#define ADC_EOC 0x80          // ADCCON1: end of conversion
+#define ADC_ST 0x40           // ADCCON1: start conversion sequence
+#define ADC_STSEL_ST 0x30     // ADCCON1: sequence triggered by ST bit
+#define ADC_SCH_MASK 0x0F     // ADCCON2: last channel of sequence
+#define ADC_SEQ_MAX_CHANNEL 7 // single-ended AIN0-AIN7
+
+static uint8 adc_lastReference = 0xFF;
+
 double mapRange(double a1, double a2, double b1, double b2, double s) {
     double result = b1 + (s - a1) * (b2 - b1) / (a2 - a1);
     return MIN(b2, MAX(result, b1));
@@ -11,9 +21,87 @@ double mapRange(double a1, double a2, double b1, double b2, double s) {
 
 uint16 adcReadSampled(uint8 channel, uint8 resolution, uint8 reference, uint8 samplesCount) {
     HalAdcSetReference(reference);
+    adc_lastReference = reference;
     uint32 samplesSum = 0;
     for (uint8 i = 0; i < samplesCount; i++) {
         samplesSum += HalAdcRead(channel, resolution);
     }
     return samplesSum /samplesCount;
 }
+
+// First conversion after a reference switch (or ADC power-up) reads off - throw it away.
+// Only switches made through this file are tracked; pass ADC_FLAG_ALWAYS_DISCARD when
+// other code (HalAdcCheckVdd, app reads) may touch the reference too.
+static void adcPrepareReference(uint8 reference, uint8 flags, uint8 channel, uint8 resolution) {
+    bool changed = (reference != adc_lastReference);
+    HalAdcSetReference(reference);
+    adc_lastReference = reference;
+    if ((flags & ADC_FLAG_DISCARD_FIRST) && (changed || (flags & ADC_FLAG_ALWAYS_DISCARD))) {
+        (void)HalAdcRead(channel, resolution);
+    }
+}
+
+static uint16 adcDecimate(uint32 sum, uint8 samplesLog2, uint8 extraBits) {
+    if (extraBits > samplesLog2) {
+        extraBits = samplesLog2;
+    }
+    return (uint16)(sum >> (samplesLog2 - extraBits));
+}
+
+uint16 adcReadOversampled(uint8 channel, uint8 resolution, uint8 reference, uint8 samplesLog2, uint8 extraBits, uint8 flags) {
+    adcPrepareReference(reference, flags, channel, resolution);
+
+    uint32 samplesSum = 0;
+    uint16 samplesCount = (uint16)1 << samplesLog2;
+    while (samplesCount--) {
+        samplesSum += HalAdcRead(channel, resolution);
+    }
+    return adcDecimate(samplesSum, samplesLog2, extraBits);
+}
+
+void adcReadSequence(uint8 lastChannel, uint8 resolution, uint8 reference, uint8 samplesLog2, uint8 extraBits,
+                     uint8 flags, uint16 *results) {
+    uint32 sums[ADC_SEQ_MAX_CHANNEL + 1];
+    uint8 channelsMask = 0;
+    uint8 ch;
+
+    if (lastChannel > ADC_SEQ_MAX_CHANNEL) {
+        lastChannel = ADC_SEQ_MAX_CHANNEL;
+    }
+    adcPrepareReference(reference, flags, 0, resolution);
+
+    for (ch = 0; ch <= lastChannel; ch++) {
+        sums[ch] = 0;
+        channelsMask |= (1 << ch);
+    }
+
+    // Same decimation encoding as ADCCON3.EDIV: 8/10/12/14-bit -> 0x00/0x10/0x20/0x30
+    uint8 decimation = (uint8)((resolution - HAL_ADC_RESOLUTION_8) << 4);
+    // Raw result is left-aligned in ADCH:ADCL; 8/10/12/14-bit -> shift 8/6/4/2
+    uint8 shift = (uint8)(10 - (resolution << 1));
+
+    APCFG |= channelsMask;
+    ADCCON1 |= ADC_STSEL_ST;
+    ADCCON2 = reference | decimation | lastChannel;
+
+    uint16 passes = (uint16)1 << samplesLog2;
+    while (passes--) {
+        ADCCON1 |= ADC_ST;
+        for (ch = 0; ch <= lastChannel; ch++) {
+            while (!(ADCCON1 & ADC_EOC))
+                ;
+            int16 reading = (int16)ADCL;
+            reading |= (int16)(ADCH << 8); // reading ADCH clears EOC
+            if (reading < 0) {
+                reading = 0;
+            }
+            sums[ch] += (uint16)reading >> shift;
+        }
+    }
+
+    APCFG &= ~channelsMask;
+
+    for (ch = 0; ch <= lastChannel; ch++) {
+        results[ch] = adcDecimate(sums[ch], samplesLog2, extraBits);
+    }
+}
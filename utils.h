@@ -4,6 +4,19 @@ extern double mapRange(double a1, double a2, double b1, double b2, double s);
 
 extern uint16 adcReadSampled(uint8 channel, uint8 resolution, uint8 reference, uint8 samplesCount);
 
+// ADC engine flags
+#define ADC_FLAG_DISCARD_FIRST 0x01  // discard first conversion after a reference change
+#define ADC_FLAG_ALWAYS_DISCARD 0x02 // with DISCARD_FIRST: discard even if reference is unchanged (e.g. after sleep)
+
+// Average 2^samplesLog2 conversions using shift decimation. extraBits (<= samplesLog2 / 2 for a real gain)
+// keeps that many oversampled bits, e.g. 14-bit + samplesLog2=4, extraBits=2 -> 16-bit result.
+extern uint16 adcReadOversampled(uint8 channel, uint8 resolution, uint8 reference, uint8 samplesLog2, uint8 extraBits,
+                                 uint8 flags);
+// Convert AIN0..lastChannel (max 7) in one ADC sequence pass per sample, results[lastChannel + 1].
+// VDD/temperature channels can't be sequenced - use adcReadOversampled for those.
+extern void adcReadSequence(uint8 lastChannel, uint8 resolution, uint8 reference, uint8 samplesLog2, uint8 extraBits,
+                            uint8 flags, uint16 *results);
+
 
 #undef P
 #undef INP
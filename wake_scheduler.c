@@ -0,0 +1,160 @@
+/*********************************************************************
+ * Wake-aligned timer service
+ *
+ * Battery reports, poll control check-ins, NV flushes and the app's
+ * sensor timers each ran on their own OSAL timer, so their phases drifted
+ * apart and a sleepy device woke separately for every one of them, plus
+ * once per data poll. Timers that can run a little late are started here
+ * with a tolerance instead: the scheduler looks for a wakeup that is
+ * already planned inside [timeout, timeout + tolerance] - another
+ * pending timer, or the next data poll at the arbiter's current rate -
+ * and snaps the timer onto it. Only when nothing fits does it cost a
+ * wakeup of its own. Per hour it counts the timers started and the
+ * timer wakeups they cost after coalescing; a timer stopped or restarted
+ * before it fired is taken back out of both.
+ *********************************************************************/
+
+#include "wake_scheduler.h"
+#include "poll_arbiter.h"
+#include "Debug.h"
+#include "OSAL.h"
+
+#define WAKE_SCHEDULER_HOUR ((uint32)3600000)
+
+typedef struct {
+    uint32 fireAt; // osal_GetSystemClock() time
+    uint16 event;  // 0 = slot free
+    uint8 taskId;
+    bool ownWake;  // counted as a wakeup of its own (nothing planned to share)
+} WakeTimer_t;
+
+static WakeTimer_t wakeScheduler_Timers[WAKE_SCHEDULER_SLOTS];
+static WakeSchedulerStats_t wakeScheduler_Running = {0, 0};
+static WakeSchedulerStats_t wakeScheduler_LastHour = {0, 0};
+static uint32 wakeScheduler_HourStart = 0;
+static bool wakeScheduler_HourDone = false;
+
+static void wakeScheduler_RollHour(uint32 now) {
+    if (now - wakeScheduler_HourStart < WAKE_SCHEDULER_HOUR) {
+        return;
+    }
+    wakeScheduler_LastHour = wakeScheduler_Running;
+    wakeScheduler_HourDone = true;
+    LREP("Timer wakeups/h: %d requested, %d after coalescing\r\n", wakeScheduler_LastHour.requested,
+         wakeScheduler_LastHour.wakes);
+    wakeScheduler_Running.requested = 0;
+    wakeScheduler_Running.wakes = 0;
+    wakeScheduler_HourStart = now;
+}
+
+static WakeTimer_t *wakeScheduler_Find(uint8 task_id, uint16 event) {
+    for (uint8 i = 0; i < WAKE_SCHEDULER_SLOTS; i++) {
+        if (wakeScheduler_Timers[i].event == event && wakeScheduler_Timers[i].taskId == task_id) {
+            return &wakeScheduler_Timers[i];
+        }
+    }
+    return NULL;
+}
+
+// A pending timer goes away before firing: hand its wakeup to a timer sharing it, or take it back
+static void wakeScheduler_Drop(WakeTimer_t *timer, uint32 now) {
+    timer->event = 0;
+    if ((int32)(timer->fireAt - now) <= 0) {
+        return; // already fired - its wakeup happened
+    }
+    if (wakeScheduler_Running.requested > 0) {
+        wakeScheduler_Running.requested--;
+    }
+    if (!timer->ownWake) {
+        return;
+    }
+    for (uint8 i = 0; i < WAKE_SCHEDULER_SLOTS; i++) {
+        WakeTimer_t *other = &wakeScheduler_Timers[i];
+        if (other->event != 0 && other->fireAt == timer->fireAt) {
+            other->ownWake = true;
+            return;
+        }
+    }
+    if (wakeScheduler_Running.wakes > 0) {
+        wakeScheduler_Running.wakes--;
+    }
+}
+
+// Earliest planned wakeup in [from, to], or 0 if there is none
+static uint32 wakeScheduler_Planned(uint32 now, uint32 from, uint32 to) {
+    uint32 best = 0;
+    for (uint8 i = 0; i < WAKE_SCHEDULER_SLOTS; i++) {
+        WakeTimer_t *timer = &wakeScheduler_Timers[i];
+        if (timer->event == 0) {
+            continue;
+        }
+        if ((int32)(timer->fireAt - now) <= 0) {
+            timer->event = 0; // already fired
+            continue;
+        }
+        if ((int32)(timer->fireAt - from) >= 0 && (int32)(to - timer->fireAt) >= 0 &&
+            (best == 0 || (int32)(timer->fireAt - best) < 0)) {
+            best = timer->fireAt;
+        }
+    }
+
+#if defined(POWER_SAVING)
+    // Polls recur at the applied rate from the last poll (or poll timer restart)
+    uint32 lastPoll = pollArbiter_LastPollTime();
+    uint32 rate = pollArbiter_CurrentRate();
+    if (lastPoll != 0 && rate != 0) {
+        uint32 poll = lastPoll + rate;
+        if ((int32)(from - poll) > 0) {
+            poll += ((from - poll + rate - 1) / rate) * rate;
+        }
+        if ((int32)(to - poll) >= 0 && (best == 0 || (int32)(poll - best) < 0)) {
+            best = poll;
+        }
+    }
+#endif
+    return best;
+}
+
+void wakeScheduler_Start(uint8 task_id, uint16 event, uint32 timeout, uint32 tolerance) {
+    uint32 now = osal_GetSystemClock();
+    wakeScheduler_RollHour(now);
+
+    WakeTimer_t *timer = wakeScheduler_Find(task_id, event);
+    if (timer != NULL) {
+        wakeScheduler_Drop(timer, now); // restarting - don't align with its own old deadline
+    }
+
+    uint32 fireAt = wakeScheduler_Planned(now, now + timeout, now + timeout + tolerance);
+    bool ownWake = (fireAt == 0);
+    wakeScheduler_Running.requested++;
+    if (ownWake) {
+        fireAt = now + timeout;
+        wakeScheduler_Running.wakes++;
+    }
+
+    for (uint8 i = 0; timer == NULL && i < WAKE_SCHEDULER_SLOTS; i++) {
+        if (wakeScheduler_Timers[i].event == 0) {
+            timer = &wakeScheduler_Timers[i];
+        }
+    }
+    if (timer != NULL) {
+        timer->fireAt = fireAt;
+        timer->event = event;
+        timer->taskId = task_id;
+        timer->ownWake = ownWake;
+    }
+    osal_start_timerEx(task_id, event, fireAt - now);
+}
+
+void wakeScheduler_Stop(uint8 task_id, uint16 event) {
+    WakeTimer_t *timer = wakeScheduler_Find(task_id, event);
+    if (timer != NULL) {
+        wakeScheduler_Drop(timer, osal_GetSystemClock());
+    }
+    osal_stop_timerEx(task_id, event);
+}
+
+void wakeScheduler_Stats(WakeSchedulerStats_t *stats) {
+    wakeScheduler_RollHour(osal_GetSystemClock());
+    *stats = wakeScheduler_HourDone ? wakeScheduler_LastHour : wakeScheduler_Running;
+}
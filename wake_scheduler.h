@@ -0,0 +1,33 @@
+#ifndef WAKE_SCHEDULER_H
+#define WAKE_SCHEDULER_H
+
+#include "hal_types.h"
+
+/*
+ * Wake-aligned timer service. Drop-in for osal_start_timerEx when the
+ * event may run a little late: the timer fires at the first already
+ * planned wakeup (another scheduled timer or the next data poll) that
+ * falls within the tolerance, and only gets a wakeup of its own if none does.
+ * App periodic timers (sensor reads, the battery report cycle) belong here too.
+ */
+
+// Pending timers tracked for alignment; further timers still run, just uncoalesced and uncounted.
+// The library itself holds up to 6 (commissioning, NV flush, battery, poll control check-in).
+#ifndef WAKE_SCHEDULER_SLOTS
+    #define WAKE_SCHEDULER_SLOTS 10
+#endif
+
+// Timer wakeups only: data polls and timers started straight on OSAL are not counted.
+// A timer stopped or restarted before it fired is removed from both counts.
+typedef struct {
+    uint16 requested; // timer expiries scheduled here - the wakeups they'd cost on their own
+    uint16 wakes;     // distinct wakeups left after snapping them onto polls and each other
+} WakeSchedulerStats_t;
+
+// Fire event after timeout ms, or up to tolerance ms later to share a wakeup
+extern void wakeScheduler_Start(uint8 task_id, uint16 event, uint32 timeout, uint32 tolerance);
+extern void wakeScheduler_Stop(uint8 task_id, uint16 event);
+// Last full hour (per-hour counts); the running hour until one has passed
+extern void wakeScheduler_Stats(WakeSchedulerStats_t *stats);
+
+#endif